@@ -0,0 +1,272 @@
+// bitdic.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_BITDIC_H_
+#define OROCH_BITDIC_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "bitpck.h"
+#include "common.h"
+#include "integer_traits.h"
+
+namespace oroch {
+
+//
+// Dictionary encoding. The distinct integers of a sequence make a sorted
+// dictionary and every integer is replaced with its index in it (a code).
+// The codes are bit-packed as with bitpck_codec. This suits sequences with
+// few distinct integers that are far apart so that a frame of reference
+// does not help.
+//
+// The dictionary itself is a separate integer sequence that is supposed
+// to be encoded with some other codec. This is done by integer_codec.
+//
+// As the dictionary is sorted the order of codes is the same as the order
+// of integers. So a range of integers maps to a range of codes with a pair
+// of binary searches over the dictionary and the packed codes might be
+// scanned for it without decoding.
+//
+template <typename T>
+class bitdic_codec
+{
+public:
+	using original_t = T;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+
+	using dictionary = std::vector<original_t>;
+
+	// The number of integers decoded at once.
+	static constexpr size_t chunk_capacity = 256;
+
+	// Estimate the number of distinct integers with linear counting. The
+	// integers are hashed to a small bitmap and the estimate is derived
+	// from the fraction of bits left unset. The estimate is only accurate
+	// up to a few thousands. It stops early and returns at least the given
+	// limit as soon as the limit is reached. It also returns at least the
+	// limit if the bitmap gets nearly full as then the number is unknown.
+	template <typename Iter>
+	static size_t estimate(Iter src, Iter const end, const size_t limit)
+	{
+		uint64_t bitmap[estimate_nbits / 64] = {};
+		size_t nset = 0;
+		for (; src != end; ++src) {
+			const uint64_t h = uint64_t(unsigned_t(*src)) * 0x9e3779b97f4a7c15;
+			const size_t bit = h >> (64 - estimate_log2);
+			const uint64_t mask = uint64_t(1) << (bit % 64);
+			if (bitmap[bit / 64] & mask)
+				continue;
+			bitmap[bit / 64] |= mask;
+			if (++nset >= std::min(limit, estimate_full))
+				return std::max(limit, nset);
+		}
+
+		const double m = estimate_nbits;
+		return size_t(std::ceil(m * std::log(m / (m - nset))));
+	}
+
+	// Collect the distinct integers of a sequence.
+	template <typename Iter>
+	static void build(dictionary &dict, Iter const src, Iter const end)
+	{
+		dict.assign(src, end);
+		std::sort(dict.begin(), dict.end());
+		dict.erase(std::unique(dict.begin(), dict.end()), dict.end());
+	}
+
+	// Get the bit width of codes for a dictionary of a given size. The
+	// codes take at least a bit.
+	static size_t code_nbits(size_t ndistinct)
+	{
+		return ndistinct < 3 ? 1 : integer_traits<size_t>::usedcount(ndistinct - 1);
+	}
+
+	// Get the number of bytes required to fit codes for a given number of
+	// integers.
+	static constexpr size_t space(size_t nvalues, size_t nbits)
+	{
+		return packer::space(nvalues, nbits);
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst,
+			   Iter src,
+			   Iter const end,
+			   const dictionary &dict,
+			   const size_t nbits)
+	{
+		using encoder = bitpck_codec<original_t, code_codec>;
+		encoder::encode(dst, src, end, nbits, code_codec(dict));
+	}
+
+	template <typename Iter>
+	static void decode(Iter dst,
+			   Iter const end,
+			   src_bytes_t &src,
+			   const dictionary &dict,
+			   const size_t nbits)
+	{
+		// Unpack the codes by chunks of whole blocks and look them up.
+		const size_t c = packer::capacity(nbits);
+		const size_t step = (chunk_capacity / c) * c;
+		for (size_t n = std::distance(dst, end); n;) {
+			const size_t m = std::min(n, step);
+			unsigned_t buffer[chunk_capacity];
+			packer::decode(buffer, buffer + m, src, nbits);
+			for (size_t i = 0; i < m; i++)
+				*dst++ = dict[buffer[i]];
+			n -= m;
+		}
+	}
+
+	// Decode integers starting from a given position.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const dictionary &dict,
+				 const size_t nbits)
+	{
+		const size_t c = packer::capacity(nbits);
+		src += (first / c) * packer::block_size;
+
+		// Take the integers from a partially requested block one by one.
+		size_t index = first % c;
+		if (index) {
+			for (; index < c && dst != end; index++)
+				*dst++ = dict[packer::fetch(src, index, nbits)];
+			src += packer::block_size;
+		}
+
+		decode(dst, end, src, dict, nbits);
+	}
+
+	// Fetch the code of a single integer.
+	static size_t fetch_code(src_bytes_t src, const size_t index, const size_t nbits)
+	{
+		return packer::fetch(src, index, nbits);
+	}
+
+	// Translate a range of integers [lo, hi] to the range of codes. An
+	// empty result has elo > ehi.
+	static void range_encode(unsigned_t &elo,
+				 unsigned_t &ehi,
+				 const dictionary &dict,
+				 const original_t lo,
+				 const original_t hi)
+	{
+		const auto first = std::lower_bound(dict.begin(), dict.end(), lo);
+		const auto last = std::upper_bound(dict.begin(), dict.end(), hi);
+		if (hi < lo || first == last) {
+			elo = 1;
+			ehi = 0;
+		} else {
+			elo = unsigned_t(first - dict.begin());
+			ehi = unsigned_t(last - dict.begin() - 1);
+		}
+	}
+
+	// Find the position of the first integer equal to a given one. This
+	// is a dictionary probe followed by a scan of the packed codes.
+	// Returns nvalues if there is no such integer.
+	static size_t find(src_bytes_t src,
+			   const size_t nvalues,
+			   const dictionary &dict,
+			   const original_t value,
+			   const size_t nbits)
+	{
+		const auto it = std::lower_bound(dict.begin(), dict.end(), value);
+		if (it == dict.end() || *it != value)
+			return nvalues;
+		const unsigned_t code = unsigned_t(it - dict.begin());
+		return packer::scan_first(src, nvalues, code, code, nbits);
+	}
+
+	// Find the integers within the range [lo, hi] and mark them in a bitmap
+	// with a bit per integer. Returns the number of found integers.
+	static size_t scan(uint64_t *bitmap,
+			   src_bytes_t src,
+			   const size_t nvalues,
+			   const dictionary &dict,
+			   const original_t lo,
+			   const original_t hi,
+			   const size_t nbits)
+	{
+		unsigned_t elo, ehi;
+		range_encode(elo, ehi, dict, lo, hi);
+		return packer::scan(bitmap, src, nvalues, elo, ehi, nbits);
+	}
+
+	// Count the integers within the range [lo, hi].
+	static size_t count(src_bytes_t src,
+			    const size_t nvalues,
+			    const dictionary &dict,
+			    const original_t lo,
+			    const original_t hi,
+			    const size_t nbits)
+	{
+		unsigned_t elo, ehi;
+		range_encode(elo, ehi, dict, lo, hi);
+		return packer::count(src, nvalues, elo, ehi, nbits);
+	}
+
+private:
+	// The codes are unsigned integers of the same size as the originals.
+	using packer = bitpck_codec<unsigned_t>;
+
+	// The size of the linear counting bitmap.
+	static constexpr size_t estimate_log2 = 12;
+	static constexpr size_t estimate_nbits = size_t(1) << estimate_log2;
+	// The number of set bits in the bitmap that makes the estimate unknown.
+	static constexpr size_t estimate_full = estimate_nbits - estimate_nbits / 8;
+
+	// The value code that turns an integer into its code.
+	class code_codec
+	{
+	public:
+		using original_t = T;
+		using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+
+		code_codec(const dictionary &dict) : dict_(dict)
+		{
+		}
+
+		unsigned_t value_encode(original_t v) const
+		{
+			return unsigned_t(std::lower_bound(dict_.begin(), dict_.end(), v)
+					  - dict_.begin());
+		}
+
+	private:
+		const dictionary &dict_;
+	};
+};
+
+} // namespace oroch
+
+#endif /* OROCH_BITDIC_H_ */
@@ -0,0 +1,295 @@
+// bitdlt.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_BITDLT_H_
+#define OROCH_BITDLT_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "bitpck.h"
+#include "common.h"
+#include "integer_traits.h"
+#include "origin.h"
+
+namespace oroch {
+
+namespace detail {
+
+#if defined(__SSE2__)
+
+// Vector operations for the prefix sum of integers of a given size.
+template <size_t size>
+struct delta_lanes;
+
+template <>
+struct delta_lanes<1>
+{
+	static __m128i set(uint64_t v) { return _mm_set1_epi8(char(v)); }
+	static __m128i add(__m128i a, __m128i b) { return _mm_add_epi8(a, b); }
+	static __m128i prefix(__m128i x)
+	{
+		x = add(x, _mm_slli_si128(x, 1));
+		x = add(x, _mm_slli_si128(x, 2));
+		x = add(x, _mm_slli_si128(x, 4));
+		return add(x, _mm_slli_si128(x, 8));
+	}
+	static __m128i last(__m128i x) { return set(_mm_extract_epi16(x, 7) >> 8); }
+};
+
+template <>
+struct delta_lanes<2>
+{
+	static __m128i set(uint64_t v) { return _mm_set1_epi16(short(v)); }
+	static __m128i add(__m128i a, __m128i b) { return _mm_add_epi16(a, b); }
+	static __m128i prefix(__m128i x)
+	{
+		x = add(x, _mm_slli_si128(x, 2));
+		x = add(x, _mm_slli_si128(x, 4));
+		return add(x, _mm_slli_si128(x, 8));
+	}
+	static __m128i last(__m128i x)
+	{
+		return _mm_shuffle_epi32(_mm_shufflehi_epi16(x, 0xff), 0xff);
+	}
+};
+
+template <>
+struct delta_lanes<4>
+{
+	static __m128i set(uint64_t v) { return _mm_set1_epi32(int(v)); }
+	static __m128i add(__m128i a, __m128i b) { return _mm_add_epi32(a, b); }
+	static __m128i prefix(__m128i x)
+	{
+		x = add(x, _mm_slli_si128(x, 4));
+		return add(x, _mm_slli_si128(x, 8));
+	}
+	static __m128i last(__m128i x) { return _mm_shuffle_epi32(x, 0xff); }
+};
+
+template <>
+struct delta_lanes<8>
+{
+	static __m128i set(uint64_t v) { return _mm_set1_epi64x(int64_t(v)); }
+	static __m128i add(__m128i a, __m128i b) { return _mm_add_epi64(a, b); }
+	static __m128i prefix(__m128i x) { return add(x, _mm_slli_si128(x, 8)); }
+	static __m128i last(__m128i x) { return _mm_shuffle_epi32(x, 0xee); }
+};
+
+#endif
+
+// Turn a chunk of differences into the integers with a running sum from
+// a given base. Returns the last integer.
+template <typename T>
+inline typename integer_traits<T>::unsigned_t
+prefix_sum(T *buffer, const size_t m, typename integer_traits<T>::unsigned_t base)
+{
+	using unsigned_t = typename integer_traits<T>::unsigned_t;
+
+	size_t i = 0;
+#if defined(__SSE2__)
+	using lanes = delta_lanes<sizeof(T)>;
+	constexpr size_t nlanes = sizeof(__m128i) / sizeof(T);
+	__m128i *vbuffer = reinterpret_cast<__m128i *>(buffer);
+	__m128i vbase = lanes::set(base);
+	for (; i + nlanes <= m; i += nlanes) {
+		__m128i x = _mm_loadu_si128(vbuffer + i / nlanes);
+		x = lanes::add(lanes::prefix(x), vbase);
+		_mm_storeu_si128(vbuffer + i / nlanes, x);
+		vbase = lanes::last(x);
+	}
+	if (i)
+		base = unsigned_t(buffer[i - 1]);
+#endif
+	for (; i < m; i++) {
+		base += unsigned_t(buffer[i]);
+		buffer[i] = T(base);
+	}
+	return base;
+}
+
+} // namespace oroch::detail
+
+//
+// Bit-packing of the differences between consecutive integers (delta or D1
+// encoding). The first integer is stored as is. The differences are taken
+// relative to the smallest one and then packed as with bitpck_codec. So the
+// codec parameters are the bit width and the smallest difference that works
+// as a frame of reference. For sorted or slowly changing sequences these
+// differences take much fewer bits than the integers themselves.
+//
+// Differences wrap around so any sequence might be encoded this way.
+//
+// The decoder unpacks a chunk of differences at once and turns them into
+// the integers with a prefix sum within SIMD registers. Every integer depends
+// on all the previous ones so there is no random access.
+//
+template <typename T>
+class bitdlt_codec
+{
+public:
+	using original_t = T;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+
+	// The number of integers decoded at once.
+	static constexpr size_t chunk_capacity = 256;
+
+	// Get the number of bytes required to fit a given number of
+	// integers.
+	static constexpr size_t space(size_t nvalues, size_t nbits)
+	{
+		if (nvalues == 0)
+			return 0;
+		if (nbits == 0)
+			return sizeof(original_t);
+		return sizeof(original_t) + packer::space(nvalues - 1, nbits);
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst,
+			   Iter src,
+			   Iter const end,
+			   const size_t nbits,
+			   const original_t origin)
+	{
+		if (src == end)
+			return;
+
+		const original_t first = *src++;
+		*reinterpret_cast<original_t *>(dst) = first;
+		dst += sizeof(original_t);
+
+		if (nbits)
+			bitpck_codec<original_t, delta_codec>::encode(
+				dst, src, end, nbits, delta_codec(first, origin));
+	}
+
+	template <typename Iter>
+	static void decode(Iter dst,
+			   Iter const end,
+			   src_bytes_t &src,
+			   const size_t nbits,
+			   const original_t origin)
+	{
+		decode_from(dst, end, src, 0, nbits, origin);
+	}
+
+	// Decode integers starting from a given position. All the preceding
+	// integers have to be decoded too.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const size_t nbits,
+				 const original_t origin)
+	{
+		decode_from(dst, end, src, first, nbits, origin);
+	}
+
+private:
+	using packer = bitpck_codec<original_t, origin_codec<original_t>>;
+
+	// The value code that turns an integer into its difference from the
+	// previous one less the smallest difference.
+	class delta_codec
+	{
+	public:
+		using original_t = T;
+		using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+
+		delta_codec(original_t first, original_t origin)
+			: previous_{unsigned_t(first)}, origin_{unsigned_t(origin)}
+		{
+		}
+
+		unsigned_t value_encode(original_t v)
+		{
+			const unsigned_t u = unsigned_t(unsigned_t(v) - previous_ - origin_);
+			previous_ = unsigned_t(v);
+			return u;
+		}
+
+	private:
+		unsigned_t previous_;
+		const unsigned_t origin_;
+	};
+
+	template <typename Iter>
+	static void decode_from(Iter dst,
+				Iter const end,
+				src_bytes_t &src,
+				size_t first,
+				const size_t nbits,
+				const original_t origin)
+	{
+		const size_t n = first + std::distance(dst, end);
+		if (n == 0)
+			return;
+
+		unsigned_t base = *reinterpret_cast<const original_t *>(src);
+		src += sizeof(original_t);
+
+		// All the differences are the same so this is an arithmetic
+		// progression.
+		if (nbits == 0) {
+			base += unsigned_t(first * unsigned_t(origin));
+			for (; dst != end; ++dst) {
+				*dst = original_t(base);
+				base += unsigned_t(origin);
+			}
+			return;
+		}
+
+		if (first == 0)
+			*dst++ = original_t(base);
+		else
+			first--;
+
+		// Unpack the differences by chunks of whole blocks.
+		const size_t c = packer::capacity(nbits);
+		const size_t step = (chunk_capacity / c) * c;
+		for (size_t position = 1; position < n; position += step) {
+			const size_t m = std::min(n - position, step);
+			original_t buffer[chunk_capacity];
+			const origin_codec<original_t> vcodec(origin);
+			packer::decode(buffer, buffer + m, src, nbits, vcodec);
+			base = detail::prefix_sum(buffer, m, base);
+			if (first < m) {
+				dst = std::copy(buffer + first, buffer + m, dst);
+				first = 0;
+			} else {
+				first -= m;
+			}
+		}
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_BITDLT_H_ */
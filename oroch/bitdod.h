@@ -0,0 +1,203 @@
+// bitdod.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_BITDOD_H_
+#define OROCH_BITDOD_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#include "bitdlt.h"
+#include "common.h"
+#include "integer_traits.h"
+#include "offset.h"
+#include "optpfd.h"
+#include "zigzag.h"
+
+namespace oroch {
+
+//
+// Encoding of the second differences between integers (delta-of-delta).
+// This suits sequences that grow by nearly the same step such as the
+// timestamps of regular events. The second differences of these are
+// mostly zero.
+//
+// The first integer and the first difference are stored as is. The rest
+// of the second differences are zigzag-encoded and packed with optpfd_codec
+// so that the rare irregular steps become exceptions and the chunks without
+// them take a bit per integer. The only codec parameter is the maximum bit
+// width of the second differences.
+//
+// The decoder unpacks a chunk of second differences and turns them into
+// the integers with two prefix sums. There is no random access.
+//
+template <typename T>
+class bitdod_codec
+{
+public:
+	using original_t = T;
+	using signed_t = typename integer_traits<original_t>::signed_t;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+
+	// The number of integers decoded at once. This is a whole number of
+	// optpfd chunks.
+	static constexpr size_t chunk_capacity = 2 * optpfd_codec<unsigned_t>::chunk_capacity;
+
+	// Get the number of bytes required to encode a given integer sequence.
+	template <typename Iter>
+	static size_t space(Iter src, Iter const end, const size_t nbits)
+	{
+		if (src == end)
+			return 0;
+		const original_t first = *src++;
+		if (src == end)
+			return sizeof(original_t);
+		const original_t second = *src++;
+
+		return 2 * sizeof(original_t)
+		       + packer::space(src, end, nbits, dod_codec(first, second));
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst, Iter src, Iter const end, const size_t nbits)
+	{
+		if (src == end)
+			return;
+		const original_t first = *src++;
+		store(dst, first);
+		if (src == end)
+			return;
+		const original_t second = *src++;
+		store(dst, original_t(unsigned_t(second) - unsigned_t(first)));
+
+		packer::encode(dst, src, end, nbits, dod_codec(first, second));
+	}
+
+	template <typename Iter>
+	static void decode(Iter dst, Iter const end, src_bytes_t &src, const size_t nbits)
+	{
+		decode_from(dst, end, src, 0, nbits);
+	}
+
+	// Decode integers starting from a given position. All the preceding
+	// integers have to be decoded too.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const size_t nbits)
+	{
+		decode_from(dst, end, src, first, nbits);
+	}
+
+private:
+	// The value code that turns an integer into its zigzag-encoded second
+	// difference. It chains two delta codes.
+	class dod_codec
+	{
+	public:
+		using original_t = T;
+		using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+
+		dod_codec(original_t first, original_t second)
+			: value_{unsigned_t(second)},
+			  delta_{unsigned_t(unsigned_t(second) - unsigned_t(first))}
+		{
+		}
+
+		unsigned_t value_encode(original_t v)
+		{
+			using signed_t = typename integer_traits<original_t>::signed_t;
+			const unsigned_t delta = value_.value_encode(unsigned_t(v));
+			const signed_t ddelta = signed_t(delta_.value_encode(delta));
+			return zigzag_codec<original_t>::encode(ddelta);
+		}
+
+	private:
+		offset_codec<unsigned_t, 0, false> value_;
+		offset_codec<unsigned_t, 0, false> delta_;
+	};
+
+	using packer = optpfd_codec<original_t, dod_codec>;
+
+	static void store(dst_bytes_t &dst, original_t value)
+	{
+		*reinterpret_cast<original_t *>(dst) = value;
+		dst += sizeof(original_t);
+	}
+
+	static unsigned_t load(src_bytes_t &src)
+	{
+		const original_t value = *reinterpret_cast<const original_t *>(src);
+		src += sizeof(original_t);
+		return unsigned_t(value);
+	}
+
+	template <typename Iter>
+	static void decode_from(Iter dst,
+				Iter const end,
+				src_bytes_t &src,
+				size_t first,
+				const size_t nbits)
+	{
+		const size_t n = first + std::distance(dst, end);
+		if (n == 0)
+			return;
+
+		unsigned_t value = load(src);
+		if (first == 0)
+			*dst++ = original_t(value);
+		else
+			first--;
+		if (n == 1)
+			return;
+
+		unsigned_t delta = load(src);
+		value += delta;
+		if (first == 0)
+			*dst++ = original_t(value);
+		else
+			first--;
+
+		for (size_t position = 2; position < n; position += chunk_capacity) {
+			const size_t m = std::min(n - position, chunk_capacity);
+			unsigned_t buffer[chunk_capacity];
+			optpfd_codec<unsigned_t>::decode(buffer, buffer + m, src, nbits);
+			for (size_t i = 0; i < m; i++) {
+				using zigzag_t = zigzag_codec<original_t>;
+				buffer[i] = unsigned_t(zigzag_t::decode(buffer[i]));
+			}
+			delta = detail::prefix_sum(buffer, m, delta);
+			value = detail::prefix_sum(buffer, m, value);
+			for (size_t i = first; i < m; i++)
+				*dst++ = original_t(buffer[i]);
+			first -= std::min(first, m);
+		}
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_BITDOD_H_ */
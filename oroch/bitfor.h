@@ -68,10 +68,71 @@ public:
 		basic_codec::decode(dst, end, src, params.nbits, params);
 	}
 
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const parameters &params)
+	{
+		basic_codec::decode_range(dst, end, src, first, params.nbits, params);
+	}
+
 	static original_t fetch(src_bytes_t src, const size_t index, const parameters &params)
 	{
 		return basic_codec::fetch(src, index, params.nbits, params);
 	}
+
+	template <typename IndexIter, typename Iter>
+	static void gather(src_bytes_t src,
+			   IndexIter ibegin,
+			   IndexIter const iend,
+			   Iter out,
+			   const parameters &params)
+	{
+		basic_codec::gather(src, ibegin, iend, out, params.nbits, params);
+	}
+
+	// Find the integers within the range [lo, hi] and mark them in a bitmap.
+	// The range is translated to the differences from the origin so that
+	// the packed data is compared as is. Predicates like == and < are the
+	// special cases of the range. Returns the number of found integers.
+	static size_t scan(uint64_t *bitmap,
+			   src_bytes_t src,
+			   const size_t nvalues,
+			   const original_t lo,
+			   const original_t hi,
+			   const parameters &params)
+	{
+		unsigned_t elo, ehi;
+		params.range_encode(elo, ehi, lo, hi);
+		return basic_codec::scan(bitmap, src, nvalues, elo, ehi, params.nbits);
+	}
+
+	// Find the first integer within the range [lo, hi]. Returns nvalues
+	// if there is no such integer.
+	static size_t scan_first(src_bytes_t src,
+				 const size_t nvalues,
+				 const original_t lo,
+				 const original_t hi,
+				 const parameters &params)
+	{
+		unsigned_t elo, ehi;
+		params.range_encode(elo, ehi, lo, hi);
+		return basic_codec::scan_first(src, nvalues, elo, ehi, params.nbits);
+	}
+
+	// Count the integers within the range [lo, hi].
+	static size_t count(src_bytes_t src,
+			    const size_t nvalues,
+			    const original_t lo,
+			    const original_t hi,
+			    const parameters &params)
+	{
+		unsigned_t elo, ehi;
+		params.range_encode(elo, ehi, lo, hi);
+		return basic_codec::count(src, nvalues, elo, ehi, params.nbits);
+	}
 };
 
 } // namespace oroch
@@ -0,0 +1,307 @@
+// bitlin.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_BITLIN_H_
+#define OROCH_BITLIN_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+
+#include "bitdlt.h"
+#include "bitpck.h"
+#include "common.h"
+#include "integer_traits.h"
+
+namespace oroch {
+
+namespace detail {
+
+// Add a line that starts from a given base and grows by a given slope per
+// position to a chunk of integers.
+template <typename T>
+inline void
+add_line(T *buffer,
+	 const size_t m,
+	 typename integer_traits<T>::unsigned_t base,
+	 const typename integer_traits<T>::unsigned_t slope)
+{
+	using unsigned_t = typename integer_traits<T>::unsigned_t;
+
+	size_t i = 0;
+#if defined(__SSE2__)
+	using lanes = delta_lanes<sizeof(T)>;
+	constexpr size_t nlanes = sizeof(__m128i) / sizeof(T);
+	if (m >= nlanes) {
+		unsigned_t start[nlanes];
+		for (size_t k = 0; k < nlanes; k++)
+			start[k] = unsigned_t(base + unsigned_t(slope * k));
+		__m128i vline = _mm_loadu_si128(reinterpret_cast<const __m128i *>(start));
+		const __m128i vstep = lanes::set(unsigned_t(slope * nlanes));
+		__m128i *vbuffer = reinterpret_cast<__m128i *>(buffer);
+		for (; i + nlanes <= m; i += nlanes) {
+			const __m128i x = _mm_loadu_si128(vbuffer + i / nlanes);
+			_mm_storeu_si128(vbuffer + i / nlanes, lanes::add(x, vline));
+			vline = lanes::add(vline, vstep);
+		}
+		base += unsigned_t(slope * i);
+	}
+#endif
+	for (; i < m; i++) {
+		buffer[i] = T(unsigned_t(unsigned_t(buffer[i]) + base));
+		base += slope;
+	}
+}
+
+} // namespace oroch::detail
+
+//
+// Bit-packing of integers with a linear frame of reference. Instead of
+// a single base value there is a line that starts from an origin and grows
+// by a fixed slope per position. The codec packs the differences between
+// the integers and the line. For nearly arithmetic sequences such as ids
+// or offsets these differences are small no matter how much the integers
+// grow over the sequence. For exact arithmetic sequences nothing is packed
+// at all.
+//
+// The origin must be chosen so that no difference is negative. The fit()
+// function finds the suitable parameters. The slope is taken from the end
+// points of the sequence and rounded to the nearest integer.
+//
+// The decoder unpacks a chunk of differences and adds the line to them
+// with SIMD instructions while the chunk is still in the cache.
+//
+template <typename T>
+class bitlin_codec
+{
+public:
+	using original_t = T;
+	using signed_t = typename integer_traits<original_t>::signed_t;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+
+	struct parameters
+	{
+		parameters(original_t o, original_t s, size_t n) : origin(o), slope(s), nbits(n)
+		{
+		}
+
+		const original_t origin;
+		const original_t slope;
+		const size_t nbits;
+	};
+
+	// The number of integers decoded at once.
+	static constexpr size_t chunk_capacity = 256;
+
+	// Find the line and the bit width for a given integer sequence.
+	template <typename Iter>
+	static parameters fit(Iter src, Iter const end)
+	{
+		if (src == end)
+			return parameters(0, 0, 0);
+
+		const unsigned_t first = unsigned_t(*src);
+		const unsigned_t slope = unsigned_t(fit_slope(src, end));
+
+		signed_t dmin = std::numeric_limits<signed_t>::max();
+		signed_t dmax = std::numeric_limits<signed_t>::min();
+		unsigned_t line = first;
+		for (; src != end; ++src) {
+			const signed_t d = signed_t(unsigned_t(unsigned_t(*src) - line));
+			dmin = std::min(dmin, d);
+			dmax = std::max(dmax, d);
+			line += slope;
+		}
+
+		const unsigned_t range = unsigned_t(dmax) - unsigned_t(dmin);
+		return parameters(original_t(unsigned_t(first + unsigned_t(dmin))),
+				  original_t(slope),
+				  integer_traits<unsigned_t>::usedcount(range));
+	}
+
+	// Find the slope of the line through the end points of a given integer
+	// sequence rounded to the nearest integer.
+	template <typename Iter>
+	static original_t fit_slope(Iter src, Iter const end)
+	{
+		const size_t n = std::distance(src, end);
+		if (n < 2)
+			return 0;
+
+		Iter last = src;
+		std::advance(last, n - 1);
+		const int64_t rise = signed_t(unsigned_t(unsigned_t(*last) - unsigned_t(*src)));
+		const int64_t run = int64_t(n - 1);
+		int64_t step = rise / run;
+		const int64_t rest = rise % run;
+		if (2 * (rest < 0 ? -rest : rest) >= run)
+			step += rise < 0 ? -1 : 1;
+		return original_t(unsigned_t(step));
+	}
+
+	// Find the bit width of the differences from a given line for a sample
+	// of an integer sequence. The sample is made of runs of consecutive
+	// integers of a given length taken at every given number of positions.
+	// The width is no more than the one that fit() finds for the whole
+	// sequence with the same line.
+	template <typename Iter>
+	static size_t fit_sample(Iter src,
+				 Iter const end,
+				 const size_t run,
+				 const size_t step,
+				 const original_t first,
+				 const original_t slope)
+	{
+		signed_t dmin = std::numeric_limits<signed_t>::max();
+		signed_t dmax = std::numeric_limits<signed_t>::min();
+		for (size_t i = 0; src != end; ++src, ++i) {
+			const size_t pos = i / run * step + i % run;
+			const uint64_t rise = uint64_t(unsigned_t(slope)) * pos;
+			const unsigned_t line = unsigned_t(uint64_t(unsigned_t(first)) + rise);
+			const signed_t d = signed_t(unsigned_t(unsigned_t(*src) - line));
+			dmin = std::min(dmin, d);
+			dmax = std::max(dmax, d);
+		}
+		if (dmin > dmax)
+			return 0;
+		return integer_traits<unsigned_t>::usedcount(unsigned_t(dmax) - unsigned_t(dmin));
+	}
+
+	// Get the number of bytes required to fit a given number of
+	// integers.
+	static constexpr size_t space(size_t nvalues, size_t nbits)
+	{
+		return nbits ? packer::space(nvalues, nbits) : 0;
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst, Iter src, Iter const end, const parameters &params)
+	{
+		if (params.nbits)
+			bitpck_codec<original_t, line_codec>::encode(
+				dst, src, end, params.nbits, line_codec(params));
+	}
+
+	template <typename Iter>
+	static void
+	decode(Iter dst, Iter const end, src_bytes_t &src, const parameters &params)
+	{
+		decode_from(dst, end, src, 0, params);
+	}
+
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const parameters &params)
+	{
+		decode_from(dst, end, src, first, params);
+	}
+
+	static original_t fetch(src_bytes_t src, const size_t index, const parameters &params)
+	{
+		unsigned_t value = line_at(params, index);
+		if (params.nbits)
+			value += packer::fetch(src, index, params.nbits);
+		return original_t(value);
+	}
+
+private:
+	using packer = bitpck_codec<unsigned_t>;
+
+	// The value code that turns an integer into its difference from the
+	// line at its position.
+	class line_codec
+	{
+	public:
+		using original_t = T;
+		using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+
+		line_codec(const parameters &params)
+			: line_{unsigned_t(params.origin)}, slope_{unsigned_t(params.slope)}
+		{
+		}
+
+		unsigned_t value_encode(original_t v)
+		{
+			const unsigned_t u = unsigned_t(unsigned_t(v) - line_);
+			line_ += slope_;
+			return u;
+		}
+
+	private:
+		unsigned_t line_;
+		const unsigned_t slope_;
+	};
+
+	static unsigned_t line_at(const parameters &params, size_t index)
+	{
+		return unsigned_t(unsigned_t(params.origin)
+				  + unsigned_t(unsigned_t(params.slope) * index));
+	}
+
+	template <typename Iter>
+	static void decode_from(Iter dst,
+				Iter const end,
+				src_bytes_t &src,
+				size_t first,
+				const parameters &params)
+	{
+		// Without the differences it is just an arithmetic progression.
+		if (params.nbits == 0) {
+			unsigned_t line = line_at(params, first);
+			for (; dst != end; ++dst) {
+				*dst = original_t(line);
+				line += unsigned_t(params.slope);
+			}
+			return;
+		}
+
+		// Start from the block that contains the first integer.
+		const size_t c = packer::capacity(params.nbits);
+		src += (first / c) * packer::block_size;
+		size_t skip = first % c;
+		size_t position = first - skip;
+
+		// Unpack the differences by chunks of whole blocks and add the
+		// line to them.
+		const size_t step = (chunk_capacity / c) * c;
+		for (size_t n = std::distance(dst, end); n;) {
+			const size_t m = std::min(n + skip, step);
+			unsigned_t buffer[chunk_capacity];
+			packer::decode(buffer, buffer + m, src, params.nbits);
+			detail::add_line(
+				buffer, m, line_at(params, position), unsigned_t(params.slope));
+			dst = std::copy(buffer + skip, buffer + m, dst);
+			n -= m - skip;
+			position += m;
+			skip = 0;
+		}
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_BITLIN_H_ */
@@ -24,14 +24,109 @@
 #ifndef OROCH_BITPCK_H_
 #define OROCH_BITPCK_H_
 
+#include <algorithm>
+#include <cstdint>
 #include <iterator>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 #include "common.h"
 #include "integer_traits.h"
+#include "origin.h"
 #include "zigzag.h"
 
 namespace oroch {
 
+namespace detail {
+
+#if defined(__AVX2__)
+
+//
+// Lane controls for decoding of 64-bit integers with AVX2 instructions. Each
+// vector of 4 integers is taken from a chunk of 4 blocks. For every lane there
+// are indices of 32-bit halves of the two words that the integer spans and
+// the shift within the first word. The bit 3 of an index tells which 32-byte
+// half of the chunk contains the word.
+//
+template <size_t nbits>
+struct bitpck_permute_table
+{
+	static constexpr size_t nlanes = 4;
+	static constexpr size_t capacity = 128 / nbits;
+
+	uint32_t first[capacity][nlanes * 2];
+	uint32_t second[capacity][nlanes * 2];
+	uint64_t shift[capacity][nlanes];
+
+	constexpr bitpck_permute_table() : first{}, second{}, shift{}
+	{
+		for (size_t i = 0; i < capacity * nlanes; i++) {
+			const size_t block = i / capacity;
+			const size_t bit = (i % capacity) * nbits;
+			const size_t word = block * 2 + bit / 64;
+			const size_t next = (bit % 64 + nbits > 64) ? word + 1 : word;
+
+			const size_t vector = i / nlanes, lane = i % nlanes;
+			first[vector][lane * 2 + 0] = word * 2 + 0;
+			first[vector][lane * 2 + 1] = word * 2 + 1;
+			second[vector][lane * 2 + 0] = next * 2 + 0;
+			second[vector][lane * 2 + 1] = next * 2 + 1;
+			shift[vector][lane] = bit % 64;
+		}
+	}
+};
+
+template <size_t nbits>
+inline constexpr bitpck_permute_table<nbits> bitpck_permute_masks;
+
+#endif
+
+#if defined(__AVX512VBMI__)
+
+//
+// Lane controls for decoding of 64-bit integers with AVX-512 VBMI
+// instructions. Each vector of 8 integers is taken from a chunk of 8 blocks.
+// For every lane there are indices of 8 bytes starting with the one that
+// contains the first bit of the integer and the multishift control that
+// aligns these bytes at the integer start. This works for integers up to
+// 57 bits.
+//
+template <size_t nbits>
+struct bitpck_multishift_table
+{
+	static constexpr size_t nlanes = 8;
+	static constexpr size_t capacity = 128 / nbits;
+
+	byte_t permute[capacity][nlanes * 8];
+	uint64_t multishift[capacity][nlanes];
+
+	constexpr bitpck_multishift_table() : permute{}, multishift{}
+	{
+		for (size_t i = 0; i < capacity * nlanes; i++) {
+			const size_t block = i / capacity;
+			const size_t bit = (i % capacity) * nbits;
+			const size_t byte = block * 16 + bit / 8;
+
+			const size_t vector = i / nlanes, lane = i % nlanes;
+			for (size_t j = 0; j < 8; j++) {
+				permute[vector][lane * 8 + j] = byte + j;
+				const uint64_t offset = bit % 8 + j * 8;
+				multishift[vector][lane] |= offset << (j * 8);
+			}
+		}
+	}
+};
+
+template <size_t nbits>
+inline constexpr bitpck_multishift_table<nbits> bitpck_multishift_masks;
+
+#endif
+
+} // namespace oroch::detail
+
 //
 // Bit-packing of a number of integers into a 16-byte block. Each integer is
 // encoded with a fixed bit width.
@@ -39,11 +134,25 @@ namespace oroch {
 // By default the codec applies zigzag encoding if used on signed types.
 // This can be replaced by supplying a different value code explicitly.
 //
+// For bulk operations there is a kernel instance for each bit width with all
+// the loops unrolled and all the shifts and masks known at compile time. The
+// instance is selected through a per-width function table.
+//
+// With 64-bit integers the bulk decoder uses AVX2 permutes and variable shifts
+// or AVX-512 VBMI multishifts to decode 4 or 8 integers at once if the
+// respective instructions are available.
+//
+// The packed data might be scanned for a range of encoded values without
+// decoding. The range bounds are replicated across a word and compared
+// against all the integers in it at once with SWAR (SIMD within a register)
+// arithmetic.
+//
 template <typename T, typename V = zigzag_codec<T>>
 class bitpck_codec
 {
 public:
 	using original_t = T;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
 	using value_codec = V;
 
 	static constexpr size_t block_size = 16;
@@ -231,6 +340,14 @@ public:
 			   size_t nbits,
 			   value_codec vcodec = value_codec())
 	{
+		if (nbits > 0 && nbits <= nbits_max) {
+			using kernel = void (*)(dst_bytes_t &, Iter, Iter, value_codec &);
+			static constexpr auto kernels = detail::make_kernels<kernel, nbits_max>(
+				[](auto n) -> kernel { return &fixed_encode<n + 1, Iter>; });
+			kernels[nbits - 1](dst, src, end, vcodec);
+			return;
+		}
+
 		while (src < end)
 			block_encode(dst, src, end, nbits, vcodec);
 	}
@@ -242,6 +359,14 @@ public:
 			   size_t nbits,
 			   value_codec vcodec = value_codec())
 	{
+		if (nbits > 0 && nbits <= nbits_max) {
+			using kernel = void (*)(Iter, Iter, src_bytes_t &, value_codec &);
+			static constexpr auto kernels = detail::make_kernels<kernel, nbits_max>(
+				[](auto n) -> kernel { return &fixed_decode<n + 1, Iter>; });
+			kernels[nbits - 1](dst, end, src, vcodec);
+			return;
+		}
+
 		const size_t c = capacity(nbits);
 		for (;;) {
 			const auto d = std::distance(dst, end);
@@ -260,10 +385,540 @@ public:
 				const size_t nbits,
 				value_codec vcodec = value_codec())
 	{
+		if (nbits > 0 && nbits <= nbits_max) {
+			using kernel = original_t (*)(src_bytes_t, size_t, value_codec &);
+			static constexpr auto kernels = detail::make_kernels<kernel, nbits_max>(
+				[](auto n) -> kernel { return &fixed_fetch<n + 1>; });
+			return kernels[nbits - 1](src, index, vcodec);
+		}
+
 		size_t c = capacity(nbits);
 		src += (index / c) * block_size;
 		return block_fetch(src, index % c, nbits, vcodec);
 	}
+
+	// Decode integers starting from a given position. The decoding starts
+	// right at the block that contains the first requested integer.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const size_t nbits,
+				 value_codec vcodec = value_codec())
+	{
+		const size_t c = capacity(nbits);
+		src += (first / c) * block_size;
+
+		// Take the integers from a partially requested block one by one.
+		size_t index = first % c;
+		if (index) {
+			for (; index < c && dst != end; index++)
+				*dst++ = block_fetch(src, index, nbits, vcodec);
+			src += block_size;
+		}
+
+		decode(dst, end, src, nbits, vcodec);
+	}
+
+	// Fetch integers at a number of given positions. The positions are
+	// handled in batches. For each batch the block addresses are computed
+	// and prefetched first and only then the integers are extracted. So
+	// the memory latency for different positions overlaps.
+	template <typename IndexIter, typename Iter>
+	static void gather(src_bytes_t src,
+			   IndexIter ibegin,
+			   IndexIter const iend,
+			   Iter out,
+			   const size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		if (nbits > 0 && nbits <= nbits_max) {
+			using kernel = void (*)(
+				src_bytes_t, IndexIter, IndexIter, Iter, value_codec &);
+			static constexpr auto kernels
+				= detail::make_kernels<kernel, nbits_max>([](auto n) -> kernel {
+					  return &fixed_gather<n + 1, IndexIter, Iter>;
+				  });
+			kernels[nbits - 1](src, ibegin, iend, out, vcodec);
+			return;
+		}
+
+		while (ibegin != iend)
+			*out++ = fetch(src, *ibegin++, nbits, vcodec);
+	}
+
+	// Find the integers which encoded values lie within the range [lo, hi]
+	// and mark them in a bitmap with a bit per integer. The range bounds
+	// are compared right against the packed words with no decoding. The
+	// bitmap must have room for nvalues bits. Returns the number of found
+	// integers.
+	static size_t scan(uint64_t *bitmap,
+			   src_bytes_t src,
+			   const size_t nvalues,
+			   const unsigned_t lo,
+			   const unsigned_t hi,
+			   const size_t nbits)
+	{
+		std::fill_n(bitmap, (nvalues + 63) / 64, uint64_t(0));
+
+		const uint64_t vmax = uint64_t(int64_t(-1)) >> (64 - nbits);
+		if (lo > hi || lo > vmax)
+			return 0;
+
+		using kernel = size_t (*)(uint64_t *, src_bytes_t, size_t, uint64_t, uint64_t);
+		static constexpr auto kernels = detail::make_kernels<kernel, nbits_max>(
+			[](auto n) -> kernel { return &fixed_scan<n + 1, false>; });
+		const uint64_t top = std::min(uint64_t(hi), vmax);
+		return kernels[nbits - 1](bitmap, src, nvalues, lo, top);
+	}
+
+	// Find the first integer which encoded value lies within the range
+	// [lo, hi]. Returns nvalues if there is no such integer.
+	static size_t scan_first(src_bytes_t src,
+				 const size_t nvalues,
+				 const unsigned_t lo,
+				 const unsigned_t hi,
+				 const size_t nbits)
+	{
+		const uint64_t vmax = uint64_t(int64_t(-1)) >> (64 - nbits);
+		if (lo > hi || lo > vmax)
+			return nvalues;
+
+		using kernel = size_t (*)(uint64_t *, src_bytes_t, size_t, uint64_t, uint64_t);
+		static constexpr auto kernels = detail::make_kernels<kernel, nbits_max>(
+			[](auto n) -> kernel { return &fixed_scan<n + 1, true>; });
+		const uint64_t top = std::min(uint64_t(hi), vmax);
+		return kernels[nbits - 1](nullptr, src, nvalues, lo, top);
+	}
+
+	// Count the integers which encoded values lie within the range
+	// [lo, hi].
+	static size_t count(src_bytes_t src,
+			    const size_t nvalues,
+			    const unsigned_t lo,
+			    const unsigned_t hi,
+			    const size_t nbits)
+	{
+		const uint64_t vmax = uint64_t(int64_t(-1)) >> (64 - nbits);
+		if (lo > hi || lo > vmax)
+			return 0;
+
+		using kernel = size_t (*)(uint64_t *, src_bytes_t, size_t, uint64_t, uint64_t);
+		static constexpr auto kernels = detail::make_kernels<kernel, nbits_max>(
+			[](auto n) -> kernel { return &fixed_scan<n + 1, false>; });
+		const uint64_t top = std::min(uint64_t(hi), vmax);
+		return kernels[nbits - 1](nullptr, src, nvalues, lo, top);
+	}
+
+private:
+	// The number of positions handled at once by gather().
+	static constexpr size_t gather_batch = 32;
+
+	// The maximum bit width that has specialized kernels.
+	static constexpr size_t nbits_max = integer_traits<original_t>::nbits;
+
+	// Extract an integer with a given index from a block. The block is
+	// treated as a 128-bit little-endian word. With constant arguments
+	// this compiles to a couple of shifts and a mask.
+	static uint64_t
+	extract(const uint64_t u, const uint64_t v, const size_t index, const size_t nbits)
+	{
+		const size_t shift = index * nbits;
+		const uint64_t mask = uint64_t(int64_t(-1)) >> (64 - nbits);
+		if (shift + nbits <= 64)
+			return (u >> shift) & mask;
+		else if (shift < 64)
+			return ((u >> shift) | (v << (64 - shift))) & mask;
+		else
+			return (v >> (shift - 64)) & mask;
+	}
+
+	// Insert an integer with a given index into a block.
+	static void insert(uint64_t &u,
+			   uint64_t &v,
+			   uint64_t value,
+			   const size_t index,
+			   const size_t nbits)
+	{
+		const size_t shift = index * nbits;
+		const uint64_t mask = uint64_t(int64_t(-1)) >> (64 - nbits);
+		value &= mask;
+		if (shift + nbits <= 64) {
+			u |= value << shift;
+		} else if (shift < 64) {
+			u |= value << shift;
+			v |= value >> (64 - shift);
+		} else {
+			v |= value << (shift - 64);
+		}
+	}
+
+	template <size_t nbits, typename Iter>
+	static void fixed_encode(dst_bytes_t &dst, Iter src, Iter end, value_codec &vcodec)
+	{
+		constexpr size_t c = capacity(nbits);
+		for (; std::distance(src, end) >= std::ptrdiff_t(c); dst += block_size) {
+			uint64_t u = 0, v = 0;
+#pragma GCC unroll 128
+			for (size_t i = 0; i < c; i++)
+				insert(u, v, vcodec.value_encode(*src++), i, nbits);
+
+			uint64_t *block = reinterpret_cast<uint64_t *>(dst);
+			block[0] = u;
+			block[1] = v;
+		}
+		if (src != end)
+			block_encode(dst, src, end, nbits, vcodec);
+	}
+
+#if defined(__AVX2__)
+	// Check if the value code might be applied to vector lanes.
+	static constexpr bool wide_origin
+		= std::is_base_of<origin_codec<original_t>, value_codec>::value;
+	static constexpr bool wide_decode
+		= sizeof(original_t) == sizeof(uint64_t)
+		  && (wide_origin
+		      || std::is_same<zigzag_codec<original_t>, value_codec>::value);
+
+	static __m256i wide_value_decode(__m256i x, __m256i origin)
+	{
+		if constexpr (wide_origin) {
+			return _mm256_add_epi64(x, origin);
+		} else if constexpr (std::is_signed<original_t>::value) {
+			const __m256i sign = _mm256_and_si256(x, _mm256_set1_epi64x(1));
+			return _mm256_xor_si256(_mm256_srli_epi64(x, 1),
+						_mm256_sub_epi64(_mm256_setzero_si256(), sign));
+		} else {
+			return x;
+		}
+	}
+
+	// Collect 64-bit words from a 64-byte chunk.
+	static __m256i wide_permute(__m256i first, __m256i second, __m256i index)
+	{
+		const __m256i x = _mm256_permutevar8x32_epi32(first, index);
+		const __m256i y = _mm256_permutevar8x32_epi32(second, index);
+		const __m256i select = _mm256_slli_epi32(index, 28);
+		return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(x),
+							    _mm256_castsi256_ps(y),
+							    _mm256_castsi256_ps(select)));
+	}
+
+	// Decode a chunk of 4 blocks with AVX2 instructions.
+	template <size_t nbits>
+	static void permute_decode(original_t *dst, src_bytes_t src, const __m256i origin)
+	{
+		constexpr auto &table = detail::bitpck_permute_masks<nbits>;
+		const __m256i mask = _mm256_set1_epi64x(uint64_t(int64_t(-1)) >> (64 - nbits));
+		const __m256i v64 = _mm256_set1_epi64x(64);
+
+		const __m256i *vsrc = reinterpret_cast<const __m256i *>(src);
+		const __m256i first = _mm256_loadu_si256(vsrc);
+		const __m256i second = _mm256_loadu_si256(vsrc + 1);
+#pragma GCC unroll 128
+		for (size_t i = 0; i < table.capacity; i++) {
+			using vector_t = const __m256i *;
+			const __m256i uindex = _mm256_loadu_si256(vector_t(table.first[i]));
+			const __m256i vindex = _mm256_loadu_si256(vector_t(table.second[i]));
+			const __m256i shift = _mm256_loadu_si256(vector_t(table.shift[i]));
+			const __m256i u = wide_permute(first, second, uindex);
+			const __m256i v = wide_permute(first, second, vindex);
+
+			__m256i x = _mm256_srlv_epi64(u, shift);
+			x = _mm256_or_si256(x,
+					    _mm256_sllv_epi64(v, _mm256_sub_epi64(v64, shift)));
+			x = wide_value_decode(_mm256_and_si256(x, mask), origin);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst) + i, x);
+		}
+	}
+
+#if defined(__AVX512VBMI__)
+	static __m512i wide_value_decode(__m512i x, __m512i origin)
+	{
+		if constexpr (wide_origin) {
+			return _mm512_add_epi64(x, origin);
+		} else if constexpr (std::is_signed<original_t>::value) {
+			// The masked form of the shift avoids a bogus uninitialized
+			// variable warning with GCC 12.
+			const __m512i sign = _mm512_and_si512(x, _mm512_set1_epi64(1));
+			return _mm512_xor_si512(_mm512_maskz_srli_epi64(__mmask8(-1), x, 1),
+						_mm512_sub_epi64(_mm512_setzero_si512(), sign));
+		} else {
+			return x;
+		}
+	}
+
+	// Decode a chunk of 8 blocks with AVX-512 VBMI instructions.
+	template <size_t nbits>
+	static void multishift_decode(original_t *dst, src_bytes_t src, const __m512i origin)
+	{
+		constexpr auto &table = detail::bitpck_multishift_masks<nbits>;
+		const __m512i mask = _mm512_set1_epi64(uint64_t(int64_t(-1)) >> (64 - nbits));
+
+		const __m512i first = _mm512_loadu_si512(src);
+		const __m512i second = _mm512_loadu_si512(src + 64);
+#pragma GCC unroll 128
+		for (size_t i = 0; i < table.capacity; i++) {
+			const __m512i permute = _mm512_loadu_si512(table.permute[i]);
+			const __m512i multishift = _mm512_loadu_si512(table.multishift[i]);
+
+			__m512i x = _mm512_permutex2var_epi8(first, permute, second);
+			// The same is true for the multishift.
+			x = _mm512_maskz_multishift_epi64_epi8(__mmask64(-1), multishift, x);
+			x = wide_value_decode(_mm512_and_si512(x, mask), origin);
+			_mm512_storeu_si512(dst + i * table.nlanes, x);
+		}
+	}
+#endif
+
+	static constexpr size_t wide_batch = 256;
+
+	// Decode as many chunks of blocks as possible with vector instructions.
+	template <size_t nbits, typename Iter>
+	static void
+	wide_decode_chunks(Iter &dst, Iter end, src_bytes_t &src, value_codec &vcodec)
+	{
+#if defined(__AVX512VBMI__)
+		constexpr size_t nblocks = nbits <= 57 ? 8 : 4;
+#else
+		constexpr size_t nblocks = 4;
+#endif
+		constexpr size_t chunk = nblocks * capacity(nbits);
+		// Decode up to this many integers before copying them out.
+		constexpr size_t nchunks = (wide_batch + chunk - 1) / chunk;
+		const original_t origin = vcodec.value_decode(0);
+
+		original_t values[nchunks * chunk];
+		for (;;) {
+			const size_t navail = size_t(std::distance(dst, end)) / chunk;
+			const size_t n = std::min(navail, nchunks);
+			if (n == 0)
+				break;
+			for (size_t i = 0; i < n; i++) {
+#if defined(__AVX512VBMI__)
+				if constexpr (nblocks == 8)
+					multishift_decode<nbits>(values + i * chunk,
+								 src,
+								 _mm512_set1_epi64(origin));
+				else
+#endif
+					permute_decode<nbits>(values + i * chunk,
+							      src,
+							      _mm256_set1_epi64x(origin));
+				src += nblocks * block_size;
+			}
+			dst = std::copy_n(values, n * chunk, dst);
+		}
+	}
+#endif
+
+	template <size_t nbits, typename Iter>
+	static void fixed_decode(Iter dst, Iter end, src_bytes_t &src, value_codec &vcodec)
+	{
+		constexpr size_t c = capacity(nbits);
+#if defined(__AVX2__)
+		if constexpr (wide_decode)
+			wide_decode_chunks<nbits>(dst, end, src, vcodec);
+#endif
+		for (; std::distance(dst, end) >= std::ptrdiff_t(c); src += block_size) {
+			const uint64_t *block = reinterpret_cast<const uint64_t *>(src);
+			const uint64_t u = block[0];
+			const uint64_t v = block[1];
+#pragma GCC unroll 128
+			for (size_t i = 0; i < c; i++)
+				*dst++ = vcodec.value_decode(extract(u, v, i, nbits));
+		}
+		if (dst != end)
+			block_decode(dst, end, src, nbits, vcodec);
+	}
+
+	// Extract an integer at a given bit offset from a block without any
+	// branches. If the integer lies entirely in the second word then the
+	// part that is taken from the next word is masked out.
+	static uint64_t
+	gather_extract(const uint64_t *block, const size_t shift, const size_t nbits)
+	{
+		const size_t rest = shift % 64;
+		const uint64_t straddle = shift < 64 ? uint64_t(int64_t(-1)) : 0;
+		const uint64_t mask = uint64_t(int64_t(-1)) >> (64 - nbits);
+		const uint64_t x = block[shift / 64] >> rest;
+		const uint64_t y = ((block[1] << 1) << (63 - rest)) & straddle;
+		return (x | y) & mask;
+	}
+
+	template <size_t nbits, typename IndexIter, typename Iter>
+	static void fixed_gather(src_bytes_t src,
+				 IndexIter ibegin,
+				 IndexIter const iend,
+				 Iter out,
+				 value_codec &vcodec)
+	{
+		constexpr size_t c = capacity(nbits);
+
+		// Two batches are in flight. While the blocks for one batch
+		// are being prefetched the integers from the previous one are
+		// extracted.
+		const uint64_t *blocks[2][gather_batch];
+		size_t shifts[2][gather_batch];
+		size_t count[2] = {0, 0};
+		for (size_t batch = 0;; batch ^= 1) {
+			size_t n = 0;
+			for (; n < gather_batch && ibegin != iend; n++) {
+				const size_t index = *ibegin++;
+				const src_bytes_t block = src + (index / c) * block_size;
+				__builtin_prefetch(block);
+				blocks[batch][n] = reinterpret_cast<const uint64_t *>(block);
+				shifts[batch][n] = (index % c) * nbits;
+			}
+			count[batch] = n;
+
+			const size_t prev = batch ^ 1;
+			for (size_t i = 0; i < count[prev]; i++) {
+				const uint64_t *block = blocks[prev][i];
+				const size_t shift = shifts[prev][i];
+				const uint64_t value = gather_extract(block, shift, nbits);
+				*out++ = vcodec.value_decode(value);
+			}
+			if (n == 0)
+				break;
+		}
+	}
+
+	template <size_t nbits>
+	static original_t fixed_fetch(src_bytes_t src, const size_t index, value_codec &vcodec)
+	{
+		constexpr size_t c = capacity(nbits);
+		return block_fetch(src + (index / c) * block_size, index % c, nbits, vcodec);
+	}
+
+	// Get a mask with the lowest bit of every integer in a word with
+	// a given number of packed integers.
+	static constexpr uint64_t swar_low(const size_t nbits, const size_t nfields)
+	{
+		uint64_t mask = 0;
+		for (size_t i = 0; i < nfields; i++)
+			mask |= uint64_t(1) << (i * nbits);
+		return mask;
+	}
+
+	// Compare all the integers packed into two words at once. For every
+	// integer pair with a >= b the highest bit of the integer is set in
+	// the result. With the highest bits set in a and cleared in b the
+	// subtraction never borrows across integers.
+	static uint64_t swar_ge(const uint64_t a, const uint64_t b, const uint64_t high)
+	{
+		const uint64_t d = (a | high) - (b & ~high);
+		return ((a & ~b) | (~(a ^ b) & d)) & high;
+	}
+
+	// Mark the integers found by a SWAR comparison in a bitmap.
+	static void swar_mark(uint64_t *bitmap,
+			      const size_t index,
+			      uint64_t found,
+			      const uint64_t high,
+			      const size_t nbits)
+	{
+#if defined(__BMI2__)
+		(void) nbits;
+		const uint64_t bits = _pext_u64(found, high);
+		const size_t shift = index % 64;
+		bitmap[index / 64] |= bits << shift;
+		if (shift && (bits >> (64 - shift)) != 0)
+			bitmap[index / 64 + 1] |= bits >> (64 - shift);
+#else
+		(void) high;
+		for (; found; found &= found - 1) {
+			const size_t i = index + integer_traits<uint64_t>::ctz(found) / nbits;
+			bitmap[i / 64] |= uint64_t(1) << (i % 64);
+		}
+#endif
+	}
+
+	// Scan the packed integers for a range of values. A block is split
+	// into the integers that entirely fit the first word, the one that
+	// might straddle the words, and the ones that entirely fit the second
+	// word. The whole words are compared with SWAR operations and the
+	// straddling integer separately. Without a bitmap the found integers
+	// are only counted.
+	template <size_t nbits, bool first>
+	static size_t fixed_scan(uint64_t *bitmap,
+				 src_bytes_t src,
+				 const size_t nvalues,
+				 const uint64_t lo,
+				 const uint64_t hi)
+	{
+		constexpr size_t c = capacity(nbits);
+		constexpr size_t n0 = 64 / nbits;
+		constexpr size_t s = n0 * nbits == 64 ? n0 : n0 + 1;
+		constexpr size_t n1 = c - s;
+		constexpr size_t shift1 = s * nbits - 64;
+		constexpr uint64_t low0 = swar_low(nbits, n0);
+		constexpr uint64_t low1 = swar_low(nbits, n1);
+		constexpr uint64_t high0 = low0 << (nbits - 1);
+		constexpr uint64_t high1 = low1 << (nbits - 1);
+
+		const uint64_t lo0 = lo * low0, hi0 = hi * low0;
+		const uint64_t lo1 = lo * low1, hi1 = hi * low1;
+		const uint64_t range = hi - lo;
+
+		size_t index = 0, count = 0;
+		for (; index + c <= nvalues; index += c, src += block_size) {
+			const uint64_t *block = reinterpret_cast<const uint64_t *>(src);
+			const uint64_t u = block[0];
+			const uint64_t v = block[1];
+
+			const uint64_t found0 = swar_ge(u, lo0, high0) & swar_ge(hi0, u, high0);
+			bool straddle = false;
+			if constexpr (s > n0)
+				straddle = extract(u, v, n0, nbits) - lo <= range;
+			uint64_t found1 = 0;
+			if constexpr (n1 > 0) {
+				const uint64_t w = v >> shift1;
+				found1 = swar_ge(w, lo1, high1) & swar_ge(hi1, w, high1);
+			}
+
+			if constexpr (first) {
+				using traits = integer_traits<uint64_t>;
+				if (found0)
+					return index + traits::ctz(found0) / nbits;
+				if (straddle)
+					return index + n0;
+				if (found1)
+					return index + s + traits::ctz(found1) / nbits;
+			} else {
+				count += integer_traits<uint64_t>::popcount(found0);
+				count += integer_traits<uint64_t>::popcount(found1);
+				count += straddle;
+				if (bitmap == nullptr)
+					continue;
+				if (found0)
+					swar_mark(bitmap, index, found0, high0, nbits);
+				if (straddle) {
+					const size_t i = index + n0;
+					bitmap[i / 64] |= uint64_t(1) << (i % 64);
+				}
+				if (found1)
+					swar_mark(bitmap, index + s, found1, high1, nbits);
+			}
+		}
+
+		// Check the integers from the last partial block one by one.
+		if (index < nvalues) {
+			const uint64_t *block = reinterpret_cast<const uint64_t *>(src);
+			for (size_t i = 0; index < nvalues; i++, index++) {
+				if (extract(block[0], block[1], i, nbits) - lo > range)
+					continue;
+				if constexpr (first)
+					return index;
+				if (bitmap != nullptr)
+					bitmap[index / 64] |= uint64_t(1) << (index % 64);
+				count++;
+			}
+		}
+
+		return first ? nvalues : count;
+	}
 };
 
 } // namespace oroch
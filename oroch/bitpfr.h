@@ -40,6 +40,9 @@ public:
 	using original_t = T;
 	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
 
+	// The outlier storage. Clearing or resizing the vectors retains their
+	// memory so an object reused for many sequences stops allocating once
+	// it has seen the largest number of outliers.
 	struct exceptions
 	{
 		std::vector<size_t> indices;
@@ -54,6 +57,24 @@ public:
 
 			index = 0;
 		}
+
+		// Prepare for encoding of a sequence with a given number of
+		// outliers.
+		void reserve(size_t noutliers)
+		{
+			reset();
+			indices.reserve(noutliers);
+			values.reserve(noutliers);
+		}
+
+		// Prepare for decoding of a sequence with a given number of
+		// outliers.
+		void resize(size_t noutliers)
+		{
+			reset();
+			indices.resize(noutliers);
+			values.resize(noutliers);
+		}
 	};
 
 	struct parameters : public origin_codec<original_t>
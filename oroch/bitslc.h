@@ -0,0 +1,332 @@
+// bitslc.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_BITSLC_H_
+#define OROCH_BITSLC_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#include "common.h"
+#include "integer_traits.h"
+#include "zigzag.h"
+
+namespace oroch {
+
+//
+// Bit-sliced encoding of integers after the BitWeaving/V layout described
+// in "BitWeaving: Fast Scans for Main Memory Data Processing" by Yinan Li
+// and Jignesh M. Patel.
+//
+// Integers are split into blocks of 64. Each integer is encoded with a fixed
+// bit width. A block is stored as nbits 64-bit words, one for every bit
+// position starting from the most significant one. The word for a given bit
+// position holds that bit of all the integers in the block. The last block is
+// padded with zeros.
+//
+// This layout is meant for scans. A range predicate is evaluated for all
+// the 64 integers of a block at once going from the most significant bits.
+// As soon as every integer is found to be either inside or outside the range
+// the rest of the bits are skipped. Counting and summing up the found
+// integers takes just a popcount per word. Decoding of whole integers takes
+// a bit matrix transpose and so is slower than with the other bit-packing
+// codecs.
+//
+// By default the codec applies zigzag encoding if used on signed types.
+// This can be replaced by supplying a different value code explicitly.
+//
+template <typename T, typename V = zigzag_codec<T>>
+class bitslc_codec
+{
+public:
+	using original_t = T;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+	using value_codec = V;
+
+	static constexpr size_t word_size = sizeof(uint64_t);
+	static constexpr size_t block_capacity = 64;
+
+	// Get the number of bytes in a single block with a given width.
+	static constexpr size_t block_space(size_t nbits)
+	{
+		return word_size * nbits;
+	}
+
+	// Get the number of bytes required to fit a given number of
+	// integers.
+	static constexpr size_t space(size_t nvalues, size_t nbits)
+	{
+		return block_space(nbits) * ((nvalues + block_capacity - 1) / block_capacity);
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst,
+			   Iter src,
+			   Iter const end,
+			   size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		const uint64_t mask = value_mask(nbits);
+		while (src != end) {
+			uint64_t words[block_capacity] = {};
+			for (size_t i = 0; i < block_capacity && src != end; i++)
+				words[i] = uint64_t(vcodec.value_encode(*src++)) & mask;
+			transpose(words);
+
+			uint64_t *planes = reinterpret_cast<uint64_t *>(dst);
+			for (size_t k = 0; k < nbits; k++)
+				planes[k] = words[nbits - 1 - k];
+			dst += block_space(nbits);
+		}
+	}
+
+	template <typename Iter>
+	static void decode(Iter dst,
+			   Iter const end,
+			   src_bytes_t &src,
+			   size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		for (auto n = std::distance(dst, end); n > 0; n -= block_capacity) {
+			const uint64_t *planes = reinterpret_cast<const uint64_t *>(src);
+			uint64_t words[block_capacity] = {};
+			for (size_t k = 0; k < nbits; k++)
+				words[nbits - 1 - k] = planes[k];
+			transpose(words);
+			src += block_space(nbits);
+
+			const size_t m = std::min(size_t(n), block_capacity);
+			for (size_t i = 0; i < m; i++)
+				*dst++ = vcodec.value_decode(unsigned_t(words[i]));
+		}
+	}
+
+	static original_t fetch(src_bytes_t src,
+				const size_t index,
+				const size_t nbits,
+				value_codec vcodec = value_codec())
+	{
+		src += (index / block_capacity) * block_space(nbits);
+
+		const uint64_t *planes = reinterpret_cast<const uint64_t *>(src);
+		const size_t shift = index % block_capacity;
+		uint64_t x = 0;
+		for (size_t k = 0; k < nbits; k++)
+			x = (x << 1) | ((planes[k] >> shift) & 1);
+		return vcodec.value_decode(unsigned_t(x));
+	}
+
+	// Decode integers starting from a given position. The decoding starts
+	// right at the block that contains the first requested integer.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const size_t nbits,
+				 value_codec vcodec = value_codec())
+	{
+		src += (first / block_capacity) * block_space(nbits);
+
+		// Take the integers from a partially requested block one by one.
+		size_t index = first % block_capacity;
+		if (index) {
+			for (; index < block_capacity && dst != end; index++)
+				*dst++ = fetch(src, index, nbits, vcodec);
+			src += block_space(nbits);
+		}
+
+		decode(dst, end, src, nbits, vcodec);
+	}
+
+	// Find the integers which encoded values lie within the range [lo, hi]
+	// and mark them in a bitmap with a bit per integer. A block of integers
+	// maps to a single bitmap word. The bitmap must have room for nvalues
+	// bits. Returns the number of found integers.
+	static size_t scan(uint64_t *bitmap,
+			   src_bytes_t src,
+			   const size_t nvalues,
+			   unsigned_t lo,
+			   unsigned_t hi,
+			   const size_t nbits)
+	{
+		const size_t nwords = (nvalues + block_capacity - 1) / block_capacity;
+		if (!clamp(lo, hi, nbits)) {
+			std::fill_n(bitmap, nwords, uint64_t(0));
+			return 0;
+		}
+
+		size_t nfound = 0;
+		for (size_t i = 0; i < nwords; i++) {
+			const uint64_t found = block_scan(src, lo, hi, nbits)
+					       & tail_mask(nvalues, i);
+			nfound += integer_traits<uint64_t>::popcount(found);
+			bitmap[i] = found;
+			src += block_space(nbits);
+		}
+		return nfound;
+	}
+
+	// Find the first integer which encoded value lies within the range
+	// [lo, hi]. Returns nvalues if there is no such integer.
+	static size_t scan_first(src_bytes_t src,
+				 const size_t nvalues,
+				 unsigned_t lo,
+				 unsigned_t hi,
+				 const size_t nbits)
+	{
+		if (!clamp(lo, hi, nbits))
+			return nvalues;
+
+		const size_t nwords = (nvalues + block_capacity - 1) / block_capacity;
+		for (size_t i = 0; i < nwords; i++) {
+			const uint64_t found = block_scan(src, lo, hi, nbits)
+					       & tail_mask(nvalues, i);
+			if (found)
+				return i * block_capacity
+				       + integer_traits<uint64_t>::ctz(found);
+			src += block_space(nbits);
+		}
+		return nvalues;
+	}
+
+	// Count the integers which encoded values lie within the range
+	// [lo, hi].
+	static size_t count(src_bytes_t src,
+			    const size_t nvalues,
+			    unsigned_t lo,
+			    unsigned_t hi,
+			    const size_t nbits)
+	{
+		if (!clamp(lo, hi, nbits))
+			return 0;
+
+		const size_t nwords = (nvalues + block_capacity - 1) / block_capacity;
+		size_t nfound = 0;
+		for (size_t i = 0; i < nwords; i++) {
+			const uint64_t found = block_scan(src, lo, hi, nbits)
+					       & tail_mask(nvalues, i);
+			nfound += integer_traits<uint64_t>::popcount(found);
+			src += block_space(nbits);
+		}
+		return nfound;
+	}
+
+	// Sum up the encoded values of the integers which lie within the
+	// range [lo, hi]. Every bit position adds up the popcount of found
+	// integers that have this bit set. The sum wraps around on overflow.
+	static uint64_t sum(src_bytes_t src,
+			    const size_t nvalues,
+			    unsigned_t lo,
+			    unsigned_t hi,
+			    const size_t nbits)
+	{
+		if (!clamp(lo, hi, nbits))
+			return 0;
+
+		const size_t nwords = (nvalues + block_capacity - 1) / block_capacity;
+		uint64_t total = 0;
+		for (size_t i = 0; i < nwords; i++) {
+			const uint64_t found = block_scan(src, lo, hi, nbits)
+					       & tail_mask(nvalues, i);
+			const uint64_t *planes = reinterpret_cast<const uint64_t *>(src);
+			for (size_t k = 0; k < nbits; k++) {
+				const uint64_t n
+					= integer_traits<uint64_t>::popcount(planes[k] & found);
+				total += n << (nbits - 1 - k);
+			}
+			src += block_space(nbits);
+		}
+		return total;
+	}
+
+private:
+	static constexpr uint64_t value_mask(size_t nbits)
+	{
+		return nbits ? uint64_t(int64_t(-1)) >> (64 - nbits) : 0;
+	}
+
+	// Get the mask of valid integers in a block. Only the last block
+	// might be partial.
+	static uint64_t tail_mask(const size_t nvalues, const size_t block)
+	{
+		const size_t n = nvalues - block * block_capacity;
+		return n < block_capacity ? (uint64_t(1) << n) - 1 : uint64_t(int64_t(-1));
+	}
+
+	// Fit a range to the values that can be encoded with a given width.
+	// Returns false if the range is empty.
+	static bool clamp(unsigned_t &lo, unsigned_t &hi, const size_t nbits)
+	{
+		const uint64_t vmax = value_mask(nbits);
+		if (lo > hi || lo > vmax)
+			return false;
+		if (hi > vmax)
+			hi = unsigned_t(vmax);
+		return true;
+	}
+
+	// Compare all the integers of a block against a range going from the
+	// most significant bits. The integers that are still equal to a bound
+	// in all the bits seen so far are kept in the eq masks. The rest are
+	// already known to be either greater or lower than the bound. When
+	// there are no more undecided integers the remaining bits are skipped.
+	static uint64_t
+	block_scan(src_bytes_t src, const uint64_t lo, const uint64_t hi, const size_t nbits)
+	{
+		const uint64_t *planes = reinterpret_cast<const uint64_t *>(src);
+		uint64_t lo_eq = uint64_t(int64_t(-1)), lo_gt = 0;
+		uint64_t hi_eq = uint64_t(int64_t(-1)), hi_lt = 0;
+		for (size_t k = 0; k < nbits && (lo_eq | hi_eq) != 0; k++) {
+			const size_t bit = nbits - 1 - k;
+			const uint64_t w = planes[k];
+			const uint64_t l = -((lo >> bit) & 1);
+			const uint64_t h = -((hi >> bit) & 1);
+			lo_gt |= lo_eq & w & ~l;
+			lo_eq &= ~(w ^ l);
+			hi_lt |= hi_eq & ~w & h;
+			hi_eq &= ~(w ^ h);
+		}
+		return (lo_gt | lo_eq) & (hi_lt | hi_eq);
+	}
+
+	// Transpose a 64x64 bit matrix so that the bit i of the word j goes to
+	// the bit j of the word i. This is done by swapping ever smaller
+	// sub-matrices.
+	static void transpose(uint64_t *words)
+	{
+		uint64_t mask = 0x00000000ffffffff;
+		for (size_t j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+			for (size_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+				const uint64_t t = ((words[k] >> j) ^ words[k | j]) & mask;
+				words[k] ^= t << j;
+				words[k | j] ^= t;
+			}
+		}
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_BITSLC_H_ */
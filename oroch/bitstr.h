@@ -0,0 +1,213 @@
+// bitstr.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_BITSTR_H_
+#define OROCH_BITSTR_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include "common.h"
+#include "integer_traits.h"
+#include "zigzag.h"
+
+namespace oroch {
+
+//
+// Bit-packing of integers into a continuous bit stream. Each integer is
+// encoded with a fixed bit width. Unlike bitpck_codec there are no blocks
+// and no bits wasted at the end of each block. The stream is made of 64-bit
+// little-endian words so only the last word might be partially used.
+//
+// An integer up to 57 bits wide is extracted with a single unaligned 8-byte
+// load at its byte offset followed by a shift and a mask. Every 64 integers
+// take exactly nbits words so the bulk decoder has a kernel for each bit
+// width that handles 64 integers at once with constant offsets and shifts.
+//
+// By default the codec applies zigzag encoding if used on signed types.
+// This can be replaced by supplying a different value code explicitly.
+//
+template <typename T, typename V = zigzag_codec<T>>
+class bitstr_codec
+{
+public:
+	using original_t = T;
+	using value_codec = V;
+
+	static constexpr size_t word_size = sizeof(uint64_t);
+	static constexpr size_t word_nbits = word_size * 8;
+
+	// Get the number of bytes required to fit a given number of
+	// integers.
+	static constexpr size_t space(size_t nvalues, size_t nbits)
+	{
+		return word_size * ((nvalues * nbits + word_nbits - 1) / word_nbits);
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst,
+			   Iter src,
+			   Iter const end,
+			   size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		const uint64_t mask = uint64_t(int64_t(-1)) >> (word_nbits - nbits);
+
+		uint64_t word = 0;
+		size_t shift = 0;
+		while (src != end) {
+			const uint64_t value = vcodec.value_encode(*src++) & mask;
+			word |= value << shift;
+			shift += nbits;
+			if (shift >= word_nbits) {
+				store(dst, word);
+				shift -= word_nbits;
+				// The shift by 64 bits is not defined.
+				word = shift ? value >> (nbits - shift) : 0;
+			}
+		}
+		if (shift)
+			store(dst, word);
+	}
+
+	template <typename Iter>
+	static void decode(Iter dst,
+			   Iter const end,
+			   src_bytes_t &src,
+			   size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		size_t nvalues = std::distance(dst, end);
+		if (nbits > 0 && nbits <= nbits_max) {
+			using kernel = void (*)(Iter &, size_t, src_bytes_t, value_codec);
+			static constexpr auto kernels = detail::make_kernels<kernel, nbits_max>(
+				[](auto n) -> kernel { return &fixed_decode<n + 1, Iter>; });
+
+			const size_t nblocks = nvalues / word_nbits;
+			kernels[nbits - 1](dst, nblocks, src, vcodec);
+			src += nblocks * nbits * word_size;
+			nvalues -= nblocks * word_nbits;
+		}
+
+		for (size_t i = 0; i < nvalues; i++)
+			*dst++ = vcodec.value_decode(extract(src, i * nbits, nbits));
+		src += space(nvalues, nbits);
+	}
+
+	static original_t fetch(src_bytes_t src,
+				const size_t index,
+				const size_t nbits,
+				value_codec vcodec = value_codec())
+	{
+		return vcodec.value_decode(extract(src, index * nbits, nbits));
+	}
+
+	// Decode integers starting from a given position. The decoding starts
+	// right at the group of 64 integers that contains the first requested
+	// one.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const size_t nbits,
+				 value_codec vcodec = value_codec())
+	{
+		src += (first / word_nbits) * nbits * word_size;
+
+		// Take the integers from a partially requested group one by one.
+		size_t index = first % word_nbits;
+		if (index) {
+			for (; index < word_nbits && dst != end; index++)
+				*dst++ = fetch(src, index, nbits, vcodec);
+			src += nbits * word_size;
+		}
+
+		decode(dst, end, src, nbits, vcodec);
+	}
+
+private:
+	static constexpr size_t nbits_max = integer_traits<original_t>::nbits;
+
+	// The maximum width of integers extracted with a single load. Such an
+	// integer with any bit shift still fits 8 bytes.
+	static constexpr size_t nbits_load = word_nbits - 7;
+
+	static uint64_t load(src_bytes_t src)
+	{
+		uint64_t word;
+		std::memcpy(&word, src, word_size);
+		return word;
+	}
+
+	static void store(dst_bytes_t &dst, uint64_t word)
+	{
+		std::memcpy(dst, &word, word_size);
+		dst += word_size;
+	}
+
+	// Extract an integer at a given bit offset. An integer up to 57 bits
+	// wide is taken with a single unaligned load of 8 bytes starting at
+	// the byte with its first bit. The load is moved back if needed so
+	// that it never crosses the end of the word with the last bit of the
+	// integer and so never reads past the end of the stream. A wider
+	// integer might take two word loads.
+	static uint64_t extract(src_bytes_t src, const size_t offset, const size_t nbits)
+	{
+		const uint64_t mask = uint64_t(int64_t(-1)) >> (word_nbits - nbits);
+		if (nbits <= nbits_load) {
+			const size_t last = (offset + nbits - 1) / word_nbits * word_size;
+			const size_t index = std::min(offset / 8, last);
+			return (load(src + index) >> (offset - index * 8)) & mask;
+		}
+
+		const size_t index = offset / word_nbits;
+		const size_t shift = offset % word_nbits;
+		uint64_t x = load(src + index * word_size) >> shift;
+		if (shift + nbits > word_nbits)
+			x |= load(src + (index + 1) * word_size) << (word_nbits - shift);
+		return x & mask;
+	}
+
+	// Decode a number of 64-integer blocks with a given width. With
+	// constant width the loop is fully unrolled and all the shifts and
+	// masks are known at compile time. The value codec is passed by value
+	// so that the stores to the output cannot alias its state.
+	template <size_t nbits, typename Iter>
+	static void
+	fixed_decode(Iter &dst, size_t nblocks, src_bytes_t src, value_codec vcodec)
+	{
+		for (; nblocks; nblocks--) {
+#pragma GCC unroll 64
+			for (size_t i = 0; i < word_nbits; i++)
+				*dst++ = vcodec.value_decode(extract(src, i * nbits, nbits));
+			src += nbits * word_size;
+		}
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_BITSTR_H_ */
@@ -0,0 +1,326 @@
+// bitvec.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_BITVEC_H_
+#define OROCH_BITVEC_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "common.h"
+#include "integer_traits.h"
+#include "origin.h"
+#include "zigzag.h"
+
+namespace oroch {
+
+//
+// Vertical bit-packing of integers into blocks of 128 values as described
+// here:
+//
+// https://arxiv.org/abs/1209.2137
+//
+// A block is made of 4 interleaved 32-bit lanes. The integer with index i
+// goes to the lane i % 4 so the lanes of a 16-byte word might be unpacked
+// with SSE2 shifts and masks all at once. Each integer is encoded with
+// a fixed bit width up to 32 bits. The last block is padded with zeros.
+//
+// By default the codec applies zigzag encoding if used on signed types.
+// This can be replaced by supplying a different value code explicitly.
+// For 32-bit integers the zigzag and frame-of-reference codes are applied
+// right in the unpacking kernel.
+//
+template <typename T, typename V = zigzag_codec<T>>
+class bitvec_codec
+{
+public:
+	using original_t = T;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+	using value_codec = V;
+
+	static constexpr size_t lane_number = 4;
+	static constexpr size_t lane_nbits = 32;
+	static constexpr size_t lane_capacity = 32;
+
+	// The number of integers in a single block.
+	static constexpr size_t block_capacity = lane_number * lane_capacity;
+
+	// The maximum supported number of bits per integer.
+	static constexpr size_t nbits_max = lane_nbits < integer_traits<original_t>::nbits
+						    ? lane_nbits
+						    : integer_traits<original_t>::nbits;
+
+	// Get the number of bytes in a single block with a given width.
+	static constexpr size_t block_space(size_t nbits)
+	{
+		return lane_number * nbits * sizeof(uint32_t);
+	}
+
+	// Get the number of bytes required to fit a given number of
+	// integers.
+	static constexpr size_t space(size_t nvalues, size_t nbits)
+	{
+		return block_space(nbits) * ((nvalues + block_capacity - 1) / block_capacity);
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst,
+			   Iter src,
+			   Iter const end,
+			   size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		check(nbits);
+		while (src != end) {
+			uint32_t buffer[block_capacity] = {};
+			for (size_t i = 0; i < block_capacity && src != end; i++)
+				buffer[i] = uint32_t(vcodec.value_encode(*src++));
+			block_pack(dst, buffer, nbits);
+			dst += block_space(nbits);
+		}
+	}
+
+	template <typename Iter>
+	static void decode(Iter dst,
+			   Iter const end,
+			   src_bytes_t &src,
+			   size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		check(nbits);
+
+		using kernel = void (*)(uint32_t *, src_bytes_t, value_codec &);
+		static constexpr auto kernels = detail::make_kernels<kernel, nbits_max>(
+			[](auto n) -> kernel { return &fixed_unpack<n + 1>; });
+		const kernel unpack = kernels[nbits - 1];
+
+		alignas(16) uint32_t buffer[block_capacity];
+		for (auto n = std::distance(dst, end); n > 0; n -= block_capacity) {
+			unpack(buffer, src, vcodec);
+			src += block_space(nbits);
+
+			// If the values are already decoded then the copy might
+			// boil down to memmove.
+			const size_t m = std::min(size_t(n), block_capacity);
+			if constexpr (lanes_decoded) {
+				const original_t *values
+					= reinterpret_cast<const original_t *>(buffer);
+				dst = std::copy_n(values, m, dst);
+			} else {
+				for (size_t i = 0; i < m; i++)
+					*dst++ = vcodec.value_decode(unsigned_t(buffer[i]));
+			}
+		}
+	}
+
+	static original_t fetch(src_bytes_t src,
+				const size_t index,
+				const size_t nbits,
+				value_codec vcodec = value_codec())
+	{
+		src += (index / block_capacity) * block_space(nbits);
+
+		const size_t lane = index % lane_number;
+		const size_t shift = (index % block_capacity / lane_number) * nbits;
+		const uint32_t *words = reinterpret_cast<const uint32_t *>(src);
+		const uint32_t *word = words + (shift / lane_nbits) * lane_number + lane;
+
+		uint64_t x = word[0] >> (shift % lane_nbits);
+		if (shift % lane_nbits + nbits > lane_nbits)
+			x |= uint64_t(word[lane_number]) << (lane_nbits - shift % lane_nbits);
+		return vcodec.value_decode(unsigned_t(x & lane_mask(nbits)));
+	}
+
+	// Decode integers starting from a given position. The decoding starts
+	// right at the block that contains the first requested integer.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const size_t nbits,
+				 value_codec vcodec = value_codec())
+	{
+		src += (first / block_capacity) * block_space(nbits);
+
+		// Take the integers from a partially requested block one by one.
+		size_t index = first % block_capacity;
+		if (index) {
+			for (; index < block_capacity && dst != end; index++)
+				*dst++ = fetch(src, index, nbits, vcodec);
+			src += block_space(nbits);
+		}
+
+		decode(dst, end, src, nbits, vcodec);
+	}
+
+	// Find the first integer which encoded value lies within the range
+	// [lo, hi]. The blocks are unpacked one at a time as raw lanes with
+	// no value code and the scan stops at the first match. Returns
+	// nvalues if there is no such integer.
+	static size_t scan_first(src_bytes_t src,
+				 const size_t nvalues,
+				 const unsigned_t lo,
+				 const unsigned_t hi,
+				 const size_t nbits)
+	{
+		check(nbits);
+		if (lo > hi || lo > lane_mask(nbits))
+			return nvalues;
+
+		// The raw lanes are the 32-bit unsigned integers.
+		using lane_codec = bitvec_codec<uint32_t>;
+		const uint32_t base = uint32_t(lo);
+		const uint32_t range = uint32_t(std::min<uint64_t>(hi, lane_mask(nbits))) - base;
+
+		alignas(16) uint32_t buffer[block_capacity];
+		for (size_t index = 0; index < nvalues; index += block_capacity) {
+			const size_t m = std::min(nvalues - index, block_capacity);
+			lane_codec::decode(buffer, buffer + m, src, nbits);
+			for (size_t i = 0; i < m; i++) {
+				if (uint32_t(buffer[i] - base) <= range)
+					return index + i;
+			}
+		}
+		return nvalues;
+	}
+
+private:
+	// Check if the value code is frame of reference.
+	static constexpr bool lanes_origin
+		= std::is_base_of<origin_codec<original_t>, value_codec>::value;
+
+	// Check if the unpacking kernel applies the value code by itself.
+	static constexpr bool lanes_decoded
+		= sizeof(original_t) == sizeof(uint32_t)
+		  && (lanes_origin
+		      || std::is_same<zigzag_codec<original_t>, value_codec>::value);
+
+	static constexpr uint32_t lane_mask(size_t nbits)
+	{
+		return uint32_t(-1) >> (lane_nbits - nbits);
+	}
+
+	static void check(size_t nbits)
+	{
+		if (nbits == 0 || nbits > nbits_max)
+			throw std::logic_error("unsupported bit width for vertical packing");
+	}
+
+	static void block_pack(dst_bytes_t dst, const uint32_t *buffer, size_t nbits)
+	{
+		uint32_t words[lane_number * lane_nbits] = {};
+		for (size_t i = 0; i < block_capacity; i++) {
+			const uint32_t value = buffer[i] & lane_mask(nbits);
+			const size_t lane = i % lane_number;
+			const size_t shift = (i / lane_number) * nbits;
+			uint32_t *word = words + (shift / lane_nbits) * lane_number + lane;
+
+			word[0] |= value << (shift % lane_nbits);
+			if (shift % lane_nbits + nbits > lane_nbits)
+				word[lane_number] |= value >> (lane_nbits - shift % lane_nbits);
+		}
+		std::memcpy(dst, words, block_space(nbits));
+	}
+
+#if defined(__SSE2__)
+	static __m128i lanes_decode(__m128i x, __m128i origin)
+	{
+		if constexpr (!lanes_decoded) {
+			return x;
+		} else if constexpr (lanes_origin) {
+			return _mm_add_epi32(x, origin);
+		} else if constexpr (std::is_signed<original_t>::value) {
+			const __m128i sign = _mm_and_si128(x, _mm_set1_epi32(1));
+			return _mm_xor_si128(_mm_srli_epi32(x, 1),
+					     _mm_sub_epi32(_mm_setzero_si128(), sign));
+		} else {
+			return x;
+		}
+	}
+
+	// Unpack a block with a given width. With constant width the loop is
+	// fully unrolled with all the shifts known at compile time.
+	template <size_t nbits>
+	static void fixed_unpack(uint32_t *dst, src_bytes_t src, value_codec &vcodec)
+	{
+		const __m128i *in = reinterpret_cast<const __m128i *>(src);
+		const __m128i mask = _mm_set1_epi32(int32_t(lane_mask(nbits)));
+		__m128i origin = _mm_setzero_si128();
+		if constexpr (lanes_decoded && lanes_origin)
+			origin = _mm_set1_epi32(int32_t(vcodec.value_decode(0)));
+
+		__m128i word = _mm_loadu_si128(in++);
+#pragma GCC unroll 32
+		for (size_t i = 0; i < lane_capacity; i++) {
+			const size_t shift = (i * nbits) % lane_nbits;
+			__m128i x = _mm_srli_epi32(word, shift);
+			if (shift + nbits > lane_nbits) {
+				word = _mm_loadu_si128(in++);
+				x = _mm_or_si128(x, _mm_slli_epi32(word, lane_nbits - shift));
+			} else if (shift + nbits == lane_nbits && i + 1 < lane_capacity) {
+				word = _mm_loadu_si128(in++);
+			}
+			if (nbits < lane_nbits)
+				x = _mm_and_si128(x, mask);
+
+			x = lanes_decode(x, origin);
+			_mm_store_si128(reinterpret_cast<__m128i *>(dst + i * lane_number), x);
+		}
+	}
+#else
+	template <size_t nbits>
+	static void fixed_unpack(uint32_t *dst, src_bytes_t src, value_codec &vcodec)
+	{
+		uint32_t words[lane_number * lane_nbits];
+		std::memcpy(words, src, block_space(nbits));
+		for (size_t i = 0; i < block_capacity; i++) {
+			const size_t lane = i % lane_number;
+			const size_t shift = (i / lane_number) * nbits;
+			const uint32_t *word
+				= words + (shift / lane_nbits) * lane_number + lane;
+
+			uint64_t x = word[0] >> (shift % lane_nbits);
+			if (shift % lane_nbits + nbits > lane_nbits)
+				x |= uint64_t(word[lane_number])
+				     << (lane_nbits - shift % lane_nbits);
+			x &= lane_mask(nbits);
+			if (lanes_decoded)
+				x = uint32_t(vcodec.value_decode(unsigned_t(x)));
+			dst[i] = uint32_t(x);
+		}
+	}
+#endif
+};
+
+} // namespace oroch
+
+#endif /* OROCH_BITVEC_H_ */
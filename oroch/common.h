@@ -24,6 +24,10 @@
 #ifndef OROCH_COMMON_H_
 #define OROCH_COMMON_H_
 
+#include <array>
+#include <cstddef>
+#include <utility>
+
 namespace oroch {
 
 typedef unsigned char byte_t;
@@ -34,6 +38,26 @@ typedef byte_t *dst_bytes_t;
 
 typedef const byte_t *src_bytes_t;
 
+namespace detail {
+
+// Build a table of N kernels. The kernel for the index i is obtained by
+// calling the given function with std::integral_constant<size_t, i>.
+template <typename K, typename F, std::size_t... I>
+constexpr std::array<K, sizeof...(I)>
+make_kernels(F make_kernel, std::index_sequence<I...>)
+{
+	return {{make_kernel(std::integral_constant<std::size_t, I>())...}};
+}
+
+template <typename K, std::size_t N, typename F>
+constexpr std::array<K, N>
+make_kernels(F make_kernel)
+{
+	return make_kernels<K>(make_kernel, std::make_index_sequence<N>());
+}
+
+} // namespace oroch::detail
+
 } // namespace oroch
 
 #endif /* OROCH_COMMON_H_ */
@@ -43,17 +43,25 @@ namespace detail {
 
 constexpr size_t group_size = 256;
 
+// The distance between samples of the skip index in varint groups.
+constexpr size_t index_stride = 64;
+
+// The number of groups in a page.
+constexpr size_t page_groups = 16;
+constexpr size_t page_size = page_groups * group_size;
+
 template <typename T>
 class array_integer_group : public oroch::integer_group<T>
 {
 public:
 	using super = oroch::integer_group<T>;
 	using original_t = typename super::original_t;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
 	using codec = typename super::codec;
 
 	void encode(const original_t *buffer)
 	{
-		super::encode(buffer, buffer + group_size);
+		super::encode(buffer, buffer + group_size, true, index_stride);
 	}
 
 	void decode(original_t *buffer) const
@@ -63,8 +71,13 @@ public:
 
 	original_t operator[](size_t index) const
 	{
+		typename codec::metadata meta;
+		src_bytes_t data_bytes = super::decode(meta);
+		if (codec::has_fetch(meta))
+			return codec::fetch(data_bytes, index, meta);
+
 		std::array<original_t, group_size> buffer;
-		decode(buffer.begin());
+		codec::decode(buffer.begin(), buffer.end(), data_bytes, meta);
 		return buffer[index];
 	}
 
@@ -73,15 +86,11 @@ public:
 		size_t nbits;
 
 		typename codec::metadata meta;
-		src_bytes_t meta_bytes = super::data_.get();
-		src_bytes_t meta_start = meta_bytes;
-		meta.decode(meta_bytes);
-
-		const size_t metaspace = std::distance(meta_start, meta_bytes);
-		const size_t dataoffset
-			= (metaspace + super::alignment_mask) & ~super::alignment_mask;
+		src_bytes_t data_bytes = super::decode(meta);
+		if (meta.value_desc.stride)
+			data_bytes += skipidx_codec<varint_codec<original_t>>::index_space(
+				group_size, meta.value_desc.stride);
 
-		src_bytes_t data_bytes = super::data_.get() + dataoffset;
 		switch (meta.value_desc.encoding) {
 		case encoding_t::naught:
 			if (value == meta.value_desc.origin)
@@ -107,14 +116,64 @@ public:
 			}
 			return not_found;
 
-		case encoding_t::bitpck:
-			nbits = integer_traits<original_t>::usedcount(
-				zigzag_codec<original_t>::encode_if_signed(value));
+		case encoding_t::pfxvar:
+			for (size_t index = 0; index < group_size; index++) {
+				original_t decoded;
+				pfxvar_codec<original_t>::value_decode(decoded, data_bytes);
+				if (value == decoded)
+					return index;
+			}
+			return not_found;
+
+		case encoding_t::bitpck: {
+			const unsigned_t encoded
+				= zigzag_codec<original_t>::encode_if_signed(value);
+			nbits = integer_traits<original_t>::usedcount(encoded);
 			if (nbits > meta.value_desc.nbits)
 				return not_found;
-			break;
+			nbits = meta.value_desc.nbits;
+			return found(bitpck_codec<original_t>::scan_first(
+				data_bytes, group_size, encoded, encoded, nbits));
+		}
+
+		case encoding_t::bitfor: {
+			nbits = integer_traits<original_t>::usedcount(value
+								      - meta.value_desc.origin);
+			if (nbits > meta.value_desc.nbits)
+				return not_found;
+			typename bitfor_codec<original_t>::parameters params(
+				meta.value_desc.origin, meta.value_desc.nbits);
+			return found(bitfor_codec<original_t>::scan_first(
+				data_bytes, group_size, value, value, params));
+		}
 
-		case encoding_t::bitfor:
+		case encoding_t::bitvec: {
+			nbits = integer_traits<original_t>::usedcount(value
+								      - meta.value_desc.origin);
+			if (nbits > meta.value_desc.nbits)
+				return not_found;
+			const unsigned_t encoded
+				= origin_codec<original_t>(meta.value_desc.origin).value_encode(value);
+			return found(bitvec_codec<original_t>::scan_first(
+				data_bytes, group_size, encoded, encoded, meta.value_desc.nbits));
+		}
+
+		case encoding_t::runlen: {
+			typename codec::runs runs;
+			codec::decode_runs(runs, data_bytes, meta);
+			return found(runlen_codec<original_t>::find(runs, value));
+		}
+
+		case encoding_t::bitdic: {
+			typename codec::dictionary dict;
+			codec::decode_dictionary(dict, data_bytes, meta);
+			return found(bitdic_codec<original_t>::find(
+				data_bytes, group_size, dict, value, meta.value_desc.nbits));
+		}
+
+		case encoding_t::bitstr:
+		case encoding_t::bitslc:
+		case encoding_t::optpfd:
 			nbits = integer_traits<original_t>::usedcount(value
 								      - meta.value_desc.origin);
 			if (nbits > meta.value_desc.nbits)
@@ -142,6 +201,144 @@ public:
 		super::decode(meta);
 		os << meta << std::endl;
 	}
+
+private:
+	// Convert the result of a scan to the find() result.
+	static size_t found(size_t index)
+	{
+		return index < group_size ? index : not_found;
+	}
+};
+
+// A page of groups that pool their exceptions together. The whole page is
+// tried with the pagpfr encoding that keeps a bit width per 128 values but
+// shares the exception buckets. If this takes less memory than the groups
+// encoded one by one then the page is kept as a single pooled group.
+// Otherwise it keeps the separate groups.
+template <typename T>
+class array_integer_page
+{
+public:
+	using group = array_integer_group<T>;
+	using original_t = typename group::original_t;
+	using codec = typename group::codec;
+
+	void encode(const original_t *buffer)
+	{
+		std::array<typename codec::metadata, page_groups> metas;
+		size_t space = 0;
+		for (size_t i = 0; i < page_groups; i++) {
+			const original_t *begin = buffer + i * group_size;
+			codec::select(metas[i], begin, begin + group_size, index_stride);
+			space += group::space(metas[i]);
+		}
+
+		typename codec::metadata meta;
+		codec::select_pooled(meta, buffer, buffer + page_size);
+		if (group::space(meta) < space) {
+			pooled_.encode(buffer, buffer + page_size, meta);
+			groups_.clear();
+			return;
+		}
+
+		pooled_ = integer_group<original_t>();
+		groups_.resize(page_groups);
+		for (size_t i = 0; i < page_groups; i++) {
+			const original_t *begin = buffer + i * group_size;
+			integer_group<original_t> &g = groups_[i];
+			g.encode(begin, begin + group_size, metas[i]);
+		}
+	}
+
+	void decode(original_t *buffer) const
+	{
+		if (pooled()) {
+			pooled_.decode(buffer, buffer + page_size);
+			return;
+		}
+		for (size_t i = 0; i < page_groups; i++)
+			groups_[i].decode(buffer + i * group_size);
+	}
+
+	original_t operator[](size_t index) const
+	{
+		if (pooled())
+			return pooled_.fetch(index);
+		return groups_[index / group_size][index % group_size];
+	}
+
+	// Insert a value at a given position and return the last value that
+	// is pushed out of the page. The page chooses anew between the pooled
+	// and the separate groups only if asked to. Otherwise it keeps its
+	// layout so that a page that only takes the value pushed out of the
+	// previous one is not sized both ways.
+	original_t insert(size_t index, original_t value, bool reselect)
+	{
+		std::vector<original_t> buffer(page_size);
+		decode(buffer.data());
+
+		const original_t overflow = buffer.back();
+		std::copy_backward(buffer.begin() + index, buffer.end() - 1, buffer.end());
+		buffer[index] = value;
+
+		if (reselect) {
+			encode(buffer.data());
+		} else if (pooled()) {
+			typename codec::metadata meta;
+			codec::select_pooled(meta, buffer.begin(), buffer.end());
+			pooled_.encode(buffer.begin(), buffer.end(), meta);
+		} else {
+			for (size_t i = 0; i < page_groups; i++)
+				groups_[i].encode(buffer.data() + i * group_size);
+		}
+		return overflow;
+	}
+
+	size_t find(original_t value) const
+	{
+		if (pooled()) {
+			// Scan the page a pagpfr group at a time.
+			constexpr size_t chunk = pagpfr_codec<original_t>::group_capacity;
+			std::array<original_t, chunk> buffer;
+			for (size_t first = 0; first < page_size; first += chunk) {
+				pooled_.decode_range(first, first + chunk, buffer.begin());
+				auto it = std::find(buffer.begin(), buffer.end(), value);
+				if (it != buffer.end())
+					return first + std::distance(buffer.begin(), it);
+			}
+			return not_found;
+		}
+		for (size_t i = 0; i < page_groups; i++) {
+			size_t index = groups_[i].find(value);
+			if (index != not_found)
+				return i * group_size + index;
+		}
+		return not_found;
+	}
+
+	void info(std::ostream &os)
+	{
+		if (pooled()) {
+			typename codec::metadata meta;
+			meta.clear();
+			pooled_.decode(meta);
+			os << meta << std::endl;
+			return;
+		}
+		for (size_t i = 0; i < page_groups; i++)
+			groups_[i].info(os);
+	}
+
+private:
+	bool pooled() const
+	{
+		return groups_.empty();
+	}
+
+	// The page encoded as a whole if its exceptions are pooled.
+	integer_group<original_t> pooled_;
+	// The separate groups otherwise.
+	std::vector<group> groups_;
 };
 
 } // namespace oroch::detail
@@ -155,53 +352,60 @@ public:
 
 	bool empty() const
 	{
-		return groups_.empty() && tail_.empty();
+		return pages_.empty() && groups_.empty() && tail_.empty();
 	}
 
 	size_t size() const
 	{
-		return groups_.size() * detail::group_size + tail_.size();
+		return pages_.size() * detail::page_size + groups_.size() * detail::group_size
+		       + tail_.size();
 	}
 
 	original_t at(size_t npos) const
 	{
-		size_t ngroups = groups_.size();
-		size_t group = npos / detail::group_size;
-		size_t index = npos % detail::group_size;
-		if (group > ngroups || index > tail_.size())
+		if (npos >= size())
 			throw std::out_of_range("array index out of range");
-
-		if (group < ngroups)
-			return groups_[group][index];
-		else
-			return tail_[index];
+		return (*this)[npos];
 	}
 
 	original_t operator[](size_t npos) const
 	{
+		size_t npages = pages_.size();
+		size_t page = npos / detail::page_size;
+		if (page < npages)
+			return pages_[page][npos % detail::page_size];
+		npos -= npages * detail::page_size;
+
 		size_t ngroups = groups_.size();
 		size_t group = npos / detail::group_size;
 		size_t index = npos % detail::group_size;
 
 		if (group < ngroups)
-			return groups_[group].get(index);
+			return groups_[group][index];
 		else
 			return tail_[index];
 	}
 
 	size_t find(original_t value) const
 	{
-		size_t ngroups = groups_.size();
+		size_t npages = pages_.size();
+		for (size_t page = 0; page < npages; page++) {
+			size_t index = pages_[page].find(value);
+			if (index != not_found)
+				return page * detail::page_size + index;
+		}
 
+		size_t base = npages * detail::page_size;
+		size_t ngroups = groups_.size();
 		for (size_t group = 0; group < ngroups; group++) {
 			size_t index = groups_[group].find(value);
 			if (index != not_found)
-				return group * detail::group_size + index;
+				return base + group * detail::group_size + index;
 		}
 
 		auto it = std::find(tail_.begin(), tail_.end(), value);
 		if (it != tail_.end())
-			return (ngroups * detail::group_size
+			return (base + ngroups * detail::group_size
 				+ std::distance(tail_.begin(), it));
 
 		return not_found;
@@ -209,18 +413,31 @@ public:
 
 	void clear()
 	{
+		pages_.clear();
 		groups_.clear();
 		tail_.clear();
 	}
 
 	void insert(size_t array_index, original_t value)
 	{
+		if (array_index > size())
+			throw std::out_of_range("array index out of range");
+
+		size_t npages = pages_.size();
+		size_t page = array_index / detail::page_size;
+		if (page < npages) {
+			size_t index = array_index % detail::page_size;
+			value = pages_[page].insert(index, value, true);
+			for (page++; page < npages; page++)
+				value = pages_[page].insert(0, value, false);
+			array_index = 0;
+		} else {
+			array_index -= npages * detail::page_size;
+		}
+
 		size_t ngroups = groups_.size();
 		size_t group = array_index / detail::group_size;
 		size_t index = array_index % detail::group_size;
-		if (group > ngroups || index > tail_.size())
-			throw std::out_of_range("array index out of range");
-
 		for (; group < ngroups; group++) {
 			std::array<original_t, detail::group_size> buffer;
 			groups_[group].decode(buffer.begin());
@@ -242,10 +459,23 @@ public:
 			groups_[group].encode(std::addressof(*tail_.begin()));
 			tail_.clear();
 		}
+
+		// Gather a full page of groups.
+		if (groups_.size() == detail::page_groups) {
+			std::vector<original_t> buffer(detail::page_size);
+			for (size_t g = 0; g < detail::page_groups; g++)
+				groups_[g].decode(buffer.data() + g * detail::group_size);
+			pages_.push_back(detail::array_integer_page<original_t>());
+			pages_.back().encode(buffer.data());
+			groups_.clear();
+		}
 	}
 
 	void group_info(std::ostream &ostream)
 	{
+		size_t npages = pages_.size();
+		for (size_t page = 0; page < npages; page++)
+			pages_[page].info(ostream);
 		size_t ngroups = groups_.size();
 		for (size_t group = 0; group < ngroups; group++)
 			groups_[group].info(ostream);
@@ -254,8 +484,12 @@ public:
 private:
 	// The last array elements (their number varies from 0 to group_size - 1).
 	std::vector<original_t> tail_;
-	// The packed integer groups. Each group conrains group_size elements.
+	// The packed integer groups that do not make a full page yet. Each
+	// group contains group_size elements.
 	std::vector<detail::array_integer_group<original_t>> groups_;
+	// The pages of packed integer groups. Each page contains page_size
+	// elements.
+	std::vector<detail::array_integer_page<original_t>> pages_;
 };
 
 } // namespace oroch
@@ -24,20 +24,37 @@
 #ifndef OROCH_INTEGER_CODEC_H_
 #define OROCH_INTEGER_CODEC_H_
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <limits>
 #include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
+#include "bitdic.h"
+#include "bitdlt.h"
+#include "bitdod.h"
 #include "bitfor.h"
+#include "bitlin.h"
 #include "bitpck.h"
 #include "bitpfr.h"
+#include "bitslc.h"
+#include "bitstr.h"
+#include "bitvec.h"
 #include "common.h"
 #include "integer_stats.h"
 #include "integer_traits.h"
 #include "naught.h"
 #include "normal.h"
-#include "offset.h"
+#include "optpfd.h"
 #include "origin.h"
+#include "pagpfr.h"
+#include "pfxvar.h"
+#include "runlen.h"
+#include "skipidx.h"
+#include "svbyte.h"
 #include "varint.h"
 #include "zigzag.h"
 
@@ -51,6 +68,119 @@ enum encoding_t : byte_t {
 	bitpck = 4,
 	bitfor = 5,
 	bitpfr = 6,
+	svbyte = 7,
+	pfxvar = 8,
+	pfxfor = 9,
+	bitvec = 10,
+	bitstr = 11,
+	bitslc = 12,
+	optpfd = 13,
+	pagpfr = 14,
+	bitdlt = 15,
+	bitdod = 16,
+	runlen = 17,
+	bitdic = 18,
+	bitlin = 19,
+};
+
+// The flag in the encoding byte of the metadata that tells if the encoded
+// data is preceded by a skip index.
+constexpr byte_t encoding_skipidx = 0x80;
+
+// The number of encodings.
+constexpr size_t encoding_count = 20;
+
+// The cost function that guides the encoding selection. The cost of an
+// encoding is its size in bytes plus its estimated decode time weighted by
+// a policy. The weight tells how many bytes one nanosecond saved on every
+// value is worth. With zero weight only the size matters.
+//
+// The decode time per value in nanoseconds is kept for every encoding. The
+// built-in figures were taken with the integer_codec::calibrate() function
+// for 32-bit integers on an x86-64 machine with AVX2. They can be replaced
+// with ones measured on the current machine the same way.
+//
+// Particular encodings might also be disabled. Still the naught encoding
+// is always used for constant sequences and the normal encoding is always
+// enabled as the last resort.
+class encoding_cost
+{
+public:
+	// Select the smallest encoding. This is the default policy.
+	static encoding_cost max_compression()
+	{
+		return encoding_cost(0);
+	}
+
+	// Trade a small loss in size for a large gain in speed.
+	static encoding_cost balanced()
+	{
+		return encoding_cost(0.5);
+	}
+
+	// Select the fastest encoding unless it is much larger.
+	static encoding_cost max_speed()
+	{
+		return encoding_cost(64);
+	}
+
+	explicit encoding_cost(double weight = 0)
+		: weight_(weight),
+		  decode_cost_{{0.25, 0.43, 1.4, 0.9, 0.6, 0.42, 0.42, 0.42, 5.7,
+				5.6, 0.19, 0.76, 4.7, 0.77, 0.75, 0.7, 2.1, 0.47,
+				0.82, 1.0}},
+		  disabled_(0)
+	{
+	}
+
+	double weight() const
+	{
+		return weight_;
+	}
+
+	void weight(double weight)
+	{
+		weight_ = weight;
+	}
+
+	double decode_cost(encoding_t encoding) const
+	{
+		return decode_cost_[encoding];
+	}
+
+	void decode_cost(encoding_t encoding, double cost)
+	{
+		decode_cost_[encoding] = cost;
+	}
+
+	bool enabled(encoding_t encoding) const
+	{
+		return !(disabled_ & (1u << encoding));
+	}
+
+	void enable(encoding_t encoding)
+	{
+		disabled_ &= ~(1u << encoding);
+	}
+
+	void disable(encoding_t encoding)
+	{
+		if (encoding != encoding_t::normal)
+			disabled_ |= 1u << encoding;
+	}
+
+	// Get the cost of an encoding given its size and number of values.
+	double operator()(encoding_t encoding, size_t space, size_t nvalues) const
+	{
+		if (!enabled(encoding))
+			return std::numeric_limits<double>::infinity();
+		return space + weight_ * decode_cost_[encoding] * nvalues;
+	}
+
+private:
+	double weight_;
+	std::array<double, encoding_count> decode_cost_;
+	uint32_t disabled_;
 };
 
 namespace detail {
@@ -75,6 +205,13 @@ struct encoding_descriptor
 	// The number of bits per integer for bit-packing encodings.
 	size_t nbits;
 
+	// The step per position for the linear frame-of-reference encoding.
+	original_t slope;
+
+	// The distance between samples of the skip index for varint
+	// and pfxvar encodings or zero if there is no index.
+	size_t stride;
+
 	encoding_descriptor()
 	{
 		clear();
@@ -87,6 +224,8 @@ struct encoding_descriptor
 		metaspace = 0;
 		origin = 0;
 		nbits = 0;
+		slope = 0;
+		stride = 0;
 	}
 };
 
@@ -106,6 +245,15 @@ struct encoding_metadata
 	detail::encoding_descriptor<size_t> outlier_index_desc;
 	detail::encoding_descriptor<unsigned_t> outlier_value_desc;
 
+	// runlen metadata.
+	size_t nruns = 0;
+	detail::encoding_descriptor<original_t> run_value_desc;
+	detail::encoding_descriptor<size_t> run_end_desc;
+
+	// bitdic metadata.
+	size_t ndistinct = 0;
+	detail::encoding_descriptor<original_t> dict_desc;
+
 	size_t dataspace() const
 	{
 		return value_desc.dataspace;
@@ -123,55 +271,109 @@ struct encoding_metadata
 		noutliers = 0;
 		outlier_index_desc.clear();
 		outlier_value_desc.clear();
+
+		nruns = 0;
+		run_value_desc.clear();
+		run_end_desc.clear();
+
+		ndistinct = 0;
+		dict_desc.clear();
 	}
 
 	template <typename integer_t>
 	void encode_basic(dst_bytes_t &dst,
 			  const detail::encoding_descriptor<integer_t> &desc) const
 	{
+		using signed_t = typename integer_traits<integer_t>::signed_t;
+
 		encoding_t encoding = desc.encoding;
-		*dst++ = encoding;
+		*dst++ = encoding | (desc.stride ? encoding_skipidx : 0);
 
 		switch (encoding) {
 		case encoding_t::naught:
 		case encoding_t::varfor:
+		case encoding_t::svbyte:
+		case encoding_t::pfxfor:
 			varint_codec<integer_t>::value_encode(dst, desc.origin);
 			break;
 		case encoding_t::normal:
 		case encoding_t::varint:
+		case encoding_t::pfxvar:
+		case encoding_t::runlen:
+			break;
+		case encoding_t::bitlin:
+			varint_codec<integer_t>::value_encode(dst, desc.origin);
+			varint_codec<signed_t>::value_encode(dst, signed_t(desc.slope));
+			*dst++ = desc.nbits;
 			break;
 		case encoding_t::bitpfr:
 		case encoding_t::bitfor:
+		case encoding_t::bitvec:
+		case encoding_t::bitstr:
+		case encoding_t::bitslc:
+		case encoding_t::optpfd:
+		case encoding_t::pagpfr:
+		case encoding_t::bitdlt:
 			varint_codec<integer_t>::value_encode(dst, desc.origin);
 			[[fallthrough]];
 		case encoding_t::bitpck:
+		case encoding_t::bitdod:
+		case encoding_t::bitdic:
 			*dst++ = desc.nbits;
 			break;
 		}
+
+		if (desc.stride)
+			varint_codec<size_t>::value_encode(dst, desc.stride);
 	}
 
 	template <typename integer_t>
 	void decode_basic(src_bytes_t &src, detail::encoding_descriptor<integer_t> &desc)
 	{
-		encoding_t encoding = static_cast<encoding_t>(*src++);
+		using signed_t = typename integer_traits<integer_t>::signed_t;
+
+		byte_t flags = *src & encoding_skipidx;
+		encoding_t encoding = static_cast<encoding_t>(*src++ & ~encoding_skipidx);
 		desc.encoding = encoding;
 
 		switch (encoding) {
 		case encoding_t::naught:
 		case encoding_t::varfor:
+		case encoding_t::svbyte:
+		case encoding_t::pfxfor:
 			varint_codec<integer_t>::value_decode(desc.origin, src);
 			break;
 		case encoding_t::normal:
 		case encoding_t::varint:
+		case encoding_t::pfxvar:
+		case encoding_t::runlen:
+			break;
+		case encoding_t::bitlin:
+			varint_codec<integer_t>::value_decode(desc.origin, src);
+			desc.slope = integer_t(varint_codec<signed_t>::value_decode(src));
+			desc.nbits = *src++;
 			break;
 		case encoding_t::bitpfr:
 		case encoding_t::bitfor:
+		case encoding_t::bitvec:
+		case encoding_t::bitstr:
+		case encoding_t::bitslc:
+		case encoding_t::optpfd:
+		case encoding_t::pagpfr:
+		case encoding_t::bitdlt:
 			varint_codec<integer_t>::value_decode(desc.origin, src);
 			[[fallthrough]];
 		case encoding_t::bitpck:
+		case encoding_t::bitdod:
+		case encoding_t::bitdic:
 			desc.nbits = *src++;
 			break;
 		}
+
+		if (flags & encoding_skipidx)
+			varint_codec<size_t>::value_decode(desc.stride, src);
+		else
+			desc.stride = 0;
 	}
 
 	template <typename integer_t>
@@ -200,6 +402,15 @@ struct encoding_metadata
 			varint_codec<size_t>::value_encode(dst, noutliers);
 			encode_extra(dst, outlier_index_desc);
 			encode_extra(dst, outlier_value_desc);
+		} else if (value_desc.encoding == encoding_t::runlen) {
+			varint_codec<size_t>::value_encode(dst, nruns);
+			varint_codec<size_t>::value_encode(dst, run_value_desc.dataspace);
+			encode_basic(dst, run_value_desc);
+			encode_basic(dst, run_end_desc);
+		} else if (value_desc.encoding == encoding_t::bitdic) {
+			varint_codec<size_t>::value_encode(dst, ndistinct);
+			varint_codec<size_t>::value_encode(dst, dict_desc.dataspace);
+			encode_basic(dst, dict_desc);
 		}
 	}
 
@@ -210,6 +421,15 @@ struct encoding_metadata
 			noutliers = varint_codec<size_t>::value_decode(src);
 			decode_extra(src, outlier_index_desc);
 			decode_extra(src, outlier_value_desc);
+		} else if (value_desc.encoding == encoding_t::runlen) {
+			varint_codec<size_t>::value_decode(nruns, src);
+			varint_codec<size_t>::value_decode(run_value_desc.dataspace, src);
+			decode_basic(src, run_value_desc);
+			decode_basic(src, run_end_desc);
+		} else if (value_desc.encoding == encoding_t::bitdic) {
+			varint_codec<size_t>::value_decode(ndistinct, src);
+			varint_codec<size_t>::value_decode(dict_desc.dataspace, src);
+			decode_basic(src, dict_desc);
 		}
 	}
 };
@@ -231,8 +451,16 @@ public:
 	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
 	using metadata = encoding_metadata<original_t>;
 
+	// Select the best encoding for a given sequence. If the index stride
+	// is not zero then the varint and pfxvar encodings are accounted with
+	// a skip index to provide random access. The best encoding is the one
+	// of the lowest cost which by default is just the smallest one.
 	template <typename Iter>
-	static void select(metadata &meta, Iter const src, Iter const end)
+	static void select(metadata &meta,
+			   Iter const src,
+			   Iter const end,
+			   size_t index_stride = 0,
+			   const encoding_cost &cost = encoding_cost())
 	{
 		//
 		// Collect basic value statistics.
@@ -244,38 +472,22 @@ public:
 		// Handle trivial corner cases.
 		//
 
-		// An empty sequence.
-		if (vstat.nvalues() == 0) {
-			meta.value_desc.encoding = encoding_t::normal;
-			meta.value_desc.dataspace = 0;
-			meta.value_desc.metaspace = 0;
-			return;
-		}
-
-		// A constant or singular sequence.
-		if (vstat.min() == vstat.max()) {
-			original_t value = vstat.min();
-			meta.value_desc.encoding = encoding_t::naught;
-			meta.value_desc.dataspace = 0;
-			meta.value_desc.metaspace
-				= varint_codec<original_t>::value_space(value);
-			meta.value_desc.origin = value;
+		if (select_trivial(meta.value_desc, vstat))
 			return;
-		}
 
 		//
 		// Select the best basic encoding for the sequence.
 		//
 
-		select_basic(meta.value_desc, vstat, src, end);
+		// Both bit length histograms are collected in one more pass.
+		// These are enough to size every basic encoding.
+		vstat.build_histogram(src, end);
+		select_basic(meta.value_desc, vstat, index_stride, cost);
+		select_runs(meta, vstat, src, end, index_stride, cost);
+		select_dictionary(meta, vstat, src, end, index_stride, cost);
 		if (vstat.nvalues() < 5)
 			return;
 
-		//
-		// Compare it against patched bit-packing with a frame of
-		// reference.
-		//
-
 		// The memory required to store the nbits and origin values.
 		size_t basic_metaspace = 1 + varint_codec<original_t>::value_space(vstat.min());
 
@@ -284,8 +496,59 @@ public:
 		// Find the maximum number of bits per value.
 		size_t nbits_max = integer_traits<unsigned_t>::usedcount(range);
 
-		vstat.build_histogram(src, end);
+		//
+		// Compare it against patched bit-packing with inline exceptions.
+		// It goes first so that it wins a tie as it provides random
+		// access.
+		//
+
+		compare(meta.value_desc,
+			cost,
+			vstat.nvalues(),
+			encoding_t::optpfd,
+			basic_metaspace,
+			optpfd_codec<original_t, origin_codec<original_t>>::space(
+				src, end, nbits_max, origin_codec<original_t>(vstat.min())),
+			vstat.min(),
+			nbits_max);
+
+		//
+		// Compare it against patched bit-packing with the exceptions
+		// of all the groups pooled together. It only pays off for long
+		// sequences.
+		//
+
+		compare(meta.value_desc,
+			cost,
+			vstat.nvalues(),
+			encoding_t::pagpfr,
+			basic_metaspace,
+			pagpfr_codec<original_t, origin_codec<original_t>>::space(
+				src, end, nbits_max, origin_codec<original_t>(vstat.min())),
+			vstat.min(),
+			nbits_max);
+
+		//
+		// Compare it against bit-packing relative to a line.
+		//
+
+		select_linear(meta.value_desc, vstat, src, end, cost);
+
+		//
+		// Compare it against the second differences. Like the first ones
+		// they provide no random access.
+		//
+
+		if (!index_stride)
+			select_second_delta(meta.value_desc, vstat, src, end, cost);
+
+		//
+		// Compare it against patched bit-packing with a frame of
+		// reference.
+		//
+
 		size_t noutliers = vstat.nvalues() - vstat.histogram(0); // outlier values
+		bool outlier_index = false;
 		for (size_t nbits = 1; nbits < nbits_max; nbits++) {
 			size_t n = vstat.histogram(nbits);
 			if (n == 0)
@@ -330,26 +593,22 @@ public:
 			size_t estimate = (basic_metaspace + extra_metaspace + basic_dataspace
 					   + value_dataspace
 					   + indmin);
-			size_t selected = meta.value_desc.dataspace + meta.value_desc.metaspace;
-			if (estimate >= selected)
+			const size_t nvalues = vstat.nvalues();
+			size_t space = meta.value_desc.dataspace + meta.value_desc.metaspace;
+			double selected = cost(meta.value_desc.encoding, space, nvalues);
+			if (cost(encoding_t::bitpfr, estimate, nvalues) >= selected)
 				continue;
 
 			// Compute the really required memory for outlier indices.
-			size_t indnbits = 1, indvar = 0;
-			offset_codec<size_t, 1, false> index_codec(0);
-			for (Iter cur = src; cur < end; cur++) {
-				unsigned_t u = (*cur - vstat.min()) >> nbits;
-				if (u == 0)
-					continue;
-
-				size_t i = cur - src;
-				size_t j = index_codec.value_encode(i);
-				size_t inb = integer_traits<size_t>::usedcount(j);
-				if (indnbits < inb)
-					indnbits = inb;
-				indvar += varint_codec<size_t>::value_space(j);
+			// The info for all the widths is collected at once on the
+			// first need.
+			if (!outlier_index) {
+				vstat.build_outlier_index(src, end);
+				outlier_index = true;
 			}
+			size_t indnbits = std::max(size_t(1), vstat.outlier_index_nbits(nbits));
 			size_t indpck = bitpck_codec<size_t>::space(noutliers, indnbits);
+			size_t indvar = vstat.outlier_index_space(nbits);
 
 			// Choose between the two encodings for outlier indices.
 			encoding_t index_encoding;
@@ -365,10 +624,11 @@ public:
 			size_t required = (basic_metaspace + extra_metaspace + basic_dataspace
 					   + value_dataspace
 					   + index_dataspace);
-			if (required < selected) {
+			if (cost(encoding_t::bitpfr, required, nvalues) < selected) {
 				meta.value_desc.encoding = encoding_t::bitpfr;
 				meta.value_desc.origin = vstat.min();
 				meta.value_desc.nbits = nbits;
+				meta.value_desc.stride = 0;
 
 				meta.noutliers = noutliers;
 				meta.outlier_value_desc.encoding = value_encoding;
@@ -383,11 +643,302 @@ public:
 		}
 	}
 
+	// Select an encoding for a long sequence looking only at a sample of
+	// it. The sample is made of runs of consecutive values taken one out
+	// of every sample_stride runs so it still shows the local patterns
+	// that the patched encodings rely on. The exact minimum and maximum
+	// values are found for the whole sequence though and added to the
+	// sample so the encoding is chosen for the right value range and is
+	// always wide enough for every value. The data space is computed for
+	// the whole sequence too but only for the encodings of the kind that
+	// won on the sample. The bitpfr encoding needs exact outlier info so
+	// it is replaced with optpfd that is much the same on this kind of
+	// data and is sized with a single pass. The bitlin encoding is checked
+	// on the sample values at their own positions.
+	template <typename Iter>
+	static void select_sampled(metadata &meta,
+				   Iter const src,
+				   Iter const end,
+				   size_t sample_stride,
+				   size_t index_stride = 0,
+				   const encoding_cost &cost = encoding_cost())
+	{
+		const size_t nvalues = std::distance(src, end);
+		const size_t step = sample_run * sample_stride;
+		if (sample_stride < 2 || nvalues <= step) {
+			select(meta, src, end, index_stride, cost);
+			return;
+		}
+
+		//
+		// Collect exact value statistics.
+		//
+
+		integer_stats<original_t> vstat(src, end);
+		if (select_trivial(meta.value_desc, vstat))
+			return;
+
+		//
+		// Select the best encoding for the sample.
+		//
+
+		std::vector<original_t> sample;
+		sample.reserve((nvalues / step + 1) * sample_run);
+		for (size_t pos = 0; pos < nvalues; pos += step) {
+			Iter run = src;
+			std::advance(run, pos);
+			Iter run_end = run;
+			std::advance(run_end, std::min(sample_run, nvalues - pos));
+			sample.insert(sample.end(), run, run_end);
+		}
+		// Make the sample have the same range as the whole sequence.
+		sample.push_back(vstat.min());
+		sample.push_back(vstat.max());
+
+		metadata sampled;
+		select(sampled, sample.begin(), sample.end(), index_stride, cost);
+
+		//
+		// Size the winning kind of encodings for the whole sequence.
+		//
+
+		select_packed(meta.value_desc, vstat, cost);
+		if (!index_stride)
+			select_delta(meta.value_desc, vstat, cost);
+
+		unsigned_t range = vstat.max() - vstat.min();
+		size_t nbits_max = integer_traits<unsigned_t>::usedcount(range);
+		size_t basic_metaspace = 1 + varint_codec<original_t>::value_space(vstat.min());
+		const origin_codec<original_t> orig(vstat.min());
+
+		switch (sampled.value_desc.encoding) {
+		case encoding_t::varint:
+		case encoding_t::varfor:
+		case encoding_t::svbyte:
+		case encoding_t::pfxvar:
+		case encoding_t::pfxfor:
+			vstat.build_histogram(src, end);
+			select_bytes(meta.value_desc, vstat, index_stride, cost);
+			break;
+		case encoding_t::bitpfr:
+		case encoding_t::optpfd:
+			compare(meta.value_desc,
+				cost,
+				vstat.nvalues(),
+				encoding_t::optpfd,
+				basic_metaspace,
+				optpfd_codec<original_t, origin_codec<original_t>>::space(
+					src, end, nbits_max, orig),
+				vstat.min(),
+				nbits_max);
+			break;
+		case encoding_t::pagpfr:
+			compare(meta.value_desc,
+				cost,
+				vstat.nvalues(),
+				encoding_t::pagpfr,
+				basic_metaspace,
+				pagpfr_codec<original_t, origin_codec<original_t>>::space(
+					src, end, nbits_max, orig),
+				vstat.min(),
+				nbits_max);
+			break;
+		case encoding_t::bitdod:
+			select_second_delta(meta.value_desc, vstat, src, end, cost);
+			break;
+		case encoding_t::runlen:
+			select_runs(meta, vstat, src, end, index_stride, cost);
+			break;
+		case encoding_t::bitdic:
+			select_dictionary(meta, vstat, src, end, index_stride, cost);
+			break;
+		default:
+			break;
+		}
+
+		//
+		// The sample runs are not contiguous so a line hardly shows up
+		// in the sample itself. Instead the sampled values are checked
+		// at their own positions against the line through the end
+		// points of the whole sequence. The whole sequence is fitted
+		// only if the sample shows that the line might win.
+		//
+
+		using line_codec = bitlin_codec<original_t>;
+		const original_t slope = line_codec::fit_slope(src, end);
+		const size_t line_nbits = line_codec::fit_sample(sample.begin(),
+								 sample.end() - 2,
+								 sample_run,
+								 step,
+								 *src,
+								 slope);
+		const size_t line_space = line_codec::space(vstat.nvalues(), line_nbits);
+		const size_t space = meta.value_desc.dataspace + meta.value_desc.metaspace;
+		if (cost(encoding_t::bitlin, line_space, vstat.nvalues())
+		    < cost(meta.value_desc.encoding, space, vstat.nvalues()))
+			select_linear(meta.value_desc, vstat, src, end, cost);
+	}
+
+	// Select the bit-sliced encoding for a given sequence. At best it takes
+	// as much memory as the bitstr encoding so select() never picks it. But
+	// it is the fastest to scan so it might be chosen explicitly for data
+	// that is filtered more often than decoded.
+	template <typename Iter>
+	static void select_sliced(metadata &meta, Iter const src, Iter const end)
+	{
+		integer_stats<original_t> vstat(src, end);
+		if (vstat.nvalues() == 0) {
+			meta.value_desc.encoding = encoding_t::normal;
+			meta.value_desc.dataspace = 0;
+			meta.value_desc.metaspace = 0;
+			return;
+		}
+
+		unsigned_t range = vstat.max() - vstat.min();
+		size_t nbits = integer_traits<unsigned_t>::usedcount(range);
+
+		meta.value_desc.encoding = encoding_t::bitslc;
+		meta.value_desc.dataspace
+			= bitslc_codec<original_t>::space(vstat.nvalues(), nbits);
+		meta.value_desc.metaspace
+			= 1 + varint_codec<original_t>::value_space(vstat.min());
+		meta.value_desc.origin = vstat.min();
+		meta.value_desc.nbits = nbits;
+		meta.value_desc.stride = 0;
+	}
+
+	// Select the pagpfr encoding for a given sequence regardless of the
+	// other encodings. It is meant for a long sequence made of many small
+	// groups so that their exceptions are pooled together. The caller
+	// decides if this pays off against the groups encoded separately.
+	template <typename Iter>
+	static void select_pooled(metadata &meta, Iter const src, Iter const end)
+	{
+		integer_stats<original_t> vstat(src, end);
+		if (select_trivial(meta.value_desc, vstat))
+			return;
+
+		unsigned_t range = vstat.max() - vstat.min();
+		size_t nbits = integer_traits<unsigned_t>::usedcount(range);
+
+		using page_codec = pagpfr_codec<original_t, origin_codec<original_t>>;
+		meta.value_desc.encoding = encoding_t::pagpfr;
+		meta.value_desc.dataspace = page_codec::space(
+			src, end, nbits, origin_codec<original_t>(vstat.min()));
+		meta.value_desc.metaspace
+			= 1 + varint_codec<original_t>::value_space(vstat.min());
+		meta.value_desc.origin = vstat.min();
+		meta.value_desc.nbits = nbits;
+		meta.value_desc.stride = 0;
+	}
+
+	// Measure the decode time of every encoding on the current machine and
+	// store it in a given cost function. Most encodings are timed on the
+	// same sequence of mostly small values with rare large ones. The naught
+	// encoding is timed on a constant sequence, the runlen encoding on a
+	// sequence of long runs, and the encodings of differences on a growing
+	// sequence with slightly varying steps. An encoding that cannot be made
+	// out of its sequence keeps its previous figure.
+	static void calibrate(encoding_cost &cost, size_t nvalues = 4096, size_t nrounds = 16)
+	{
+		const original_t large = std::numeric_limits<original_t>::max()
+					 >> (integer_traits<original_t>::nbits / 2);
+		std::vector<original_t> values(nvalues), decoded(nvalues);
+		std::vector<original_t> repeated(nvalues), stepped(nvalues);
+		for (size_t i = 0; i < nvalues; i++) {
+			if (i % 61)
+				values[i] = original_t((i * 37) % 97);
+			else
+				values[i] = large - original_t(i % 7);
+			repeated[i] = original_t((i / 64 * 37) % 97);
+			stepped[i] = original_t(i * 4 + (i * 37) % 3);
+		}
+		std::vector<original_t> constant(nvalues, original_t(1));
+
+		for (size_t e = 0; e < encoding_count; e++) {
+			const encoding_t encoding = static_cast<encoding_t>(e);
+			const bool differences = encoding == encoding_t::bitdlt
+						 || encoding == encoding_t::bitdod
+						 || encoding == encoding_t::bitlin;
+			const std::vector<original_t> &input
+				= encoding == encoding_t::naught
+					  ? constant
+					  : encoding == encoding_t::runlen
+						    ? repeated
+						    : differences ? stepped : values;
+
+			metadata meta;
+			if (encoding == encoding_t::bitslc) {
+				select_sliced(meta, input.begin(), input.end());
+			} else {
+				encoding_cost only;
+				for (size_t d = 0; d < encoding_count; d++) {
+					if (d != e)
+						only.disable(static_cast<encoding_t>(d));
+				}
+				select(meta, input.begin(), input.end(), 0, only);
+			}
+			if (meta.value_desc.encoding != encoding)
+				continue;
+
+			std::vector<byte_t> bytes(meta.dataspace());
+			dst_bytes_t dst = bytes.data();
+			encode(dst, input.begin(), input.end(), meta);
+
+			double best = std::numeric_limits<double>::infinity();
+			for (size_t round = 0; round < nrounds; round++) {
+				auto start = std::chrono::steady_clock::now();
+				src_bytes_t src = bytes.data();
+				decode(decoded.begin(), decoded.end(), src, meta);
+				std::chrono::duration<double, std::nano> time
+					= std::chrono::steady_clock::now() - start;
+				best = std::min(best, time.count());
+			}
+			cost.decode_cost(encoding, best / nvalues);
+		}
+	}
+
+	// The temporary storage for bitpfr outliers. By default every thread
+	// has one that is reused for all sequences. A caller might provide its
+	// own instead.
+	using scratch = typename bitpfr_codec<original_t>::exceptions;
+
+	// The runs of equal values for the runlen encoding.
+	using runs = typename runlen_codec<original_t>::runs;
+
+	// The distinct values for the bitdic encoding.
+	using dictionary = typename bitdic_codec<original_t>::dictionary;
+
+	// The type for the sum of values.
+	using sum_t = typename std::
+		conditional<std::is_signed<original_t>::value, int64_t, uint64_t>::type;
+
 	template <typename Iter>
 	static void encode(dst_bytes_t &dst, Iter src, Iter const end, metadata &meta)
 	{
 		if (meta.value_desc.encoding == encoding_t::bitpfr)
-			encode_bitpfr(dst, src, end, meta);
+			encode_bitpfr(dst, src, end, meta, thread_scratch());
+		else if (meta.value_desc.encoding == encoding_t::runlen)
+			encode_runlen(dst, src, end, meta);
+		else if (meta.value_desc.encoding == encoding_t::bitdic)
+			encode_bitdic(dst, src, end, meta);
+		else
+			encode_basic(dst, src, end, meta.value_desc);
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst,
+			   Iter src,
+			   Iter const end,
+			   metadata &meta,
+			   scratch &outliers)
+	{
+		if (meta.value_desc.encoding == encoding_t::bitpfr)
+			encode_bitpfr(dst, src, end, meta, outliers);
+		else if (meta.value_desc.encoding == encoding_t::runlen)
+			encode_runlen(dst, src, end, meta);
+		else if (meta.value_desc.encoding == encoding_t::bitdic)
+			encode_bitdic(dst, src, end, meta);
 		else
 			encode_basic(dst, src, end, meta.value_desc);
 	}
@@ -396,35 +947,464 @@ public:
 	static void decode(Iter dst, Iter const end, src_bytes_t &src, metadata &meta)
 	{
 		if (meta.value_desc.encoding == encoding_t::bitpfr)
-			decode_bitpfr(dst, end, src, meta);
+			decode_bitpfr(dst, end, src, meta, thread_scratch());
+		else if (meta.value_desc.encoding == encoding_t::runlen)
+			decode_runlen(dst, end, src, meta);
+		else if (meta.value_desc.encoding == encoding_t::bitdic)
+			decode_bitdic(dst, end, src, meta);
+		else
+			decode_basic(dst, end, src, meta.value_desc);
+	}
+
+	template <typename Iter>
+	static void decode(Iter dst,
+			   Iter const end,
+			   src_bytes_t &src,
+			   metadata &meta,
+			   scratch &outliers)
+	{
+		if (meta.value_desc.encoding == encoding_t::bitpfr)
+			decode_bitpfr(dst, end, src, meta, outliers);
+		else if (meta.value_desc.encoding == encoding_t::runlen)
+			decode_runlen(dst, end, src, meta);
+		else if (meta.value_desc.encoding == encoding_t::bitdic)
+			decode_bitdic(dst, end, src, meta);
 		else
 			decode_basic(dst, end, src, meta.value_desc);
 	}
 
+	// Check if a single value might be fetched from the encoded data
+	// without decoding the whole sequence.
+	static bool has_fetch(const metadata &meta)
+	{
+		if (meta.value_desc.encoding == encoding_t::runlen)
+			return has_fetch_basic(meta.run_value_desc)
+			       && has_fetch_basic(meta.run_end_desc);
+		if (meta.value_desc.encoding == encoding_t::bitdic)
+			return has_fetch_basic(meta.dict_desc);
+		return has_fetch_basic(meta.value_desc);
+	}
+
+	// Fetch a single value. The varint and pfxvar encodings have to skip
+	// all the preceding values unless they are provided with a skip index.
+	// The runlen encoding looks up the run with a binary search. The bitdic
+	// encoding looks up the code in the dictionary.
+	static original_t fetch(src_bytes_t src, size_t index, const metadata &meta)
+	{
+		if (meta.value_desc.encoding == encoding_t::runlen)
+			return fetch_run(src, index, meta);
+		if (meta.value_desc.encoding == encoding_t::bitdic) {
+			const size_t code = bitdic_codec<original_t>::fetch_code(
+				src + meta.dict_desc.dataspace, index, meta.value_desc.nbits);
+			return fetch_basic(src, code, meta.dict_desc);
+		}
+		return fetch_basic(src, index, meta.value_desc);
+	}
+
+	// Decode values starting from a given position. This requires an
+	// encoding that supports random access (see has_fetch). Bit-packing
+	// encodings start right at the block with the first requested value.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const metadata &meta)
+	{
+		using zigzag_vcodec = zigzag_codec<original_t>;
+		using origin_vcodec = origin_codec<original_t>;
+
+		const detail::encoding_descriptor<original_t> &desc = meta.value_desc;
+		switch (desc.encoding) {
+		case encoding_t::naught:
+			naught_codec<original_t>::decode(dst, end, src, desc.origin);
+			break;
+		case encoding_t::normal:
+			src += normal_codec<original_t>::space(first);
+			normal_codec<original_t>::decode(dst, end, src);
+			break;
+		case encoding_t::varint:
+			decode_range_skipidx<varint_codec<original_t, zigzag_vcodec>>(
+				dst, end, src, first, desc.stride, zigzag_vcodec());
+			break;
+		case encoding_t::varfor:
+			decode_range_skipidx<varint_codec<original_t, origin_vcodec>>(
+				dst, end, src, first, desc.stride, origin_vcodec(desc.origin));
+			break;
+		case encoding_t::pfxvar:
+			decode_range_skipidx<pfxvar_codec<original_t, zigzag_vcodec>>(
+				dst, end, src, first, desc.stride, zigzag_vcodec());
+			break;
+		case encoding_t::pfxfor:
+			decode_range_skipidx<pfxvar_codec<original_t, origin_vcodec>>(
+				dst, end, src, first, desc.stride, origin_vcodec(desc.origin));
+			break;
+		case encoding_t::bitpck:
+			bitpck_codec<original_t>::decode_range(
+				dst, end, src, first, desc.nbits);
+			break;
+		case encoding_t::bitfor: {
+			typename bitfor_codec<original_t>::parameters params(desc.origin,
+									     desc.nbits);
+			bitfor_codec<original_t>::decode_range(dst, end, src, first, params);
+			break;
+		}
+		case encoding_t::bitvec:
+			bitvec_codec<original_t, origin_vcodec>::decode_range(
+				dst, end, src, first, desc.nbits, origin_vcodec(desc.origin));
+			break;
+		case encoding_t::bitstr:
+			bitstr_codec<original_t, origin_vcodec>::decode_range(
+				dst, end, src, first, desc.nbits, origin_vcodec(desc.origin));
+			break;
+		case encoding_t::bitslc:
+			bitslc_codec<original_t, origin_vcodec>::decode_range(
+				dst, end, src, first, desc.nbits, origin_vcodec(desc.origin));
+			break;
+		case encoding_t::optpfd:
+			optpfd_codec<original_t, origin_vcodec>::decode_range(
+				dst, end, src, first, desc.nbits, origin_vcodec(desc.origin));
+			break;
+		case encoding_t::pagpfr:
+			pagpfr_codec<original_t, origin_vcodec>::decode_range(
+				dst, end, src, first, desc.nbits, origin_vcodec(desc.origin));
+			break;
+		case encoding_t::bitlin: {
+			typename bitlin_codec<original_t>::parameters params(
+				desc.origin, desc.slope, desc.nbits);
+			bitlin_codec<original_t>::decode_range(dst, end, src, first, params);
+			break;
+		}
+		case encoding_t::runlen: {
+			if (!has_fetch(meta))
+				throw std::logic_error("no random access to encoded data");
+			runs r;
+			decode_runs(r, src, meta);
+			runlen_codec<original_t>::fill(dst, end, r, first);
+			break;
+		}
+		case encoding_t::bitdic: {
+			if (!has_fetch(meta))
+				throw std::logic_error("no random access to encoded data");
+			dictionary dict;
+			decode_dictionary(dict, src, meta);
+			bitdic_codec<original_t>::decode_range(
+				dst, end, src, first, dict, desc.nbits);
+			break;
+		}
+		default:
+			throw std::logic_error("no random access to encoded data");
+		}
+	}
+
+	// Check if the encoded data might be scanned for a range of values
+	// without decoding.
+	static bool has_scan(const metadata &meta)
+	{
+		switch (meta.value_desc.encoding) {
+		case encoding_t::naught:
+		case encoding_t::bitfor:
+		case encoding_t::bitslc:
+		case encoding_t::runlen:
+		case encoding_t::bitdic:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Find the values within the range [lo, hi] and mark them in a bitmap
+	// with a bit per value. This requires an encoding that supports scans
+	// (see has_scan). Returns the number of found values.
+	static size_t scan(uint64_t *bitmap,
+			   src_bytes_t src,
+			   const size_t nvalues,
+			   const original_t lo,
+			   const original_t hi,
+			   const metadata &meta)
+	{
+		const detail::encoding_descriptor<original_t> &desc = meta.value_desc;
+		switch (desc.encoding) {
+		case encoding_t::naught: {
+			const bool found = lo <= desc.origin && desc.origin <= hi;
+			for (size_t i = 0; i < nvalues; i += 64) {
+				const size_t n = nvalues - i;
+				const uint64_t mask = n < 64 ? (uint64_t(1) << n) - 1
+							     : uint64_t(int64_t(-1));
+				bitmap[i / 64] = found ? mask : 0;
+			}
+			return found ? nvalues : 0;
+		}
+		case encoding_t::bitfor: {
+			typename bitfor_codec<original_t>::parameters params(desc.origin,
+									     desc.nbits);
+			return bitfor_codec<original_t>::scan(
+				bitmap, src, nvalues, lo, hi, params);
+		}
+		case encoding_t::bitslc: {
+			unsigned_t elo, ehi;
+			origin_codec<original_t>(desc.origin).range_encode(elo, ehi, lo, hi);
+			return bitslc_codec<original_t>::scan(
+				bitmap, src, nvalues, elo, ehi, desc.nbits);
+		}
+		case encoding_t::runlen: {
+			runs r;
+			decode_runs(r, src, meta);
+			return runlen_codec<original_t>::scan(bitmap, r, nvalues, lo, hi);
+		}
+		case encoding_t::bitdic: {
+			dictionary dict;
+			decode_dictionary(dict, src, meta);
+			return bitdic_codec<original_t>::scan(
+				bitmap, src, nvalues, dict, lo, hi, desc.nbits);
+		}
+		default:
+			throw std::logic_error("no scan of encoded data");
+		}
+	}
+
+	// Count the values within the range [lo, hi]. This requires an encoding
+	// that supports scans (see has_scan).
+	static size_t count(src_bytes_t src,
+			    const size_t nvalues,
+			    const original_t lo,
+			    const original_t hi,
+			    const metadata &meta)
+	{
+		const detail::encoding_descriptor<original_t> &desc = meta.value_desc;
+		switch (desc.encoding) {
+		case encoding_t::naught:
+			return lo <= desc.origin && desc.origin <= hi ? nvalues : 0;
+		case encoding_t::bitfor: {
+			typename bitfor_codec<original_t>::parameters params(desc.origin,
+									     desc.nbits);
+			return bitfor_codec<original_t>::count(src, nvalues, lo, hi, params);
+		}
+		case encoding_t::bitslc: {
+			unsigned_t elo, ehi;
+			origin_codec<original_t>(desc.origin).range_encode(elo, ehi, lo, hi);
+			return bitslc_codec<original_t>::count(
+				src, nvalues, elo, ehi, desc.nbits);
+		}
+		case encoding_t::runlen: {
+			runs r;
+			decode_runs(r, src, meta);
+			return runlen_codec<original_t>::count(r, lo, hi);
+		}
+		case encoding_t::bitdic: {
+			dictionary dict;
+			decode_dictionary(dict, src, meta);
+			return bitdic_codec<original_t>::count(
+				src, nvalues, dict, lo, hi, desc.nbits);
+		}
+		default:
+			throw std::logic_error("no scan of encoded data");
+		}
+	}
+
+	// Sum up the values. The naught and runlen encodings do it without
+	// expanding the values.
+	static sum_t sum(src_bytes_t src, const size_t nvalues, const metadata &meta)
+	{
+		switch (meta.value_desc.encoding) {
+		case encoding_t::naught:
+			return sum_t(meta.value_desc.origin) * sum_t(nvalues);
+		case encoding_t::runlen: {
+			runs r;
+			decode_runs(r, src, meta);
+			return runlen_codec<original_t>::template sum<sum_t>(r);
+		}
+		default: {
+			std::vector<original_t> values(nvalues);
+			metadata copy = meta;
+			decode(values.begin(), values.end(), src, copy);
+			sum_t s = 0;
+			for (original_t value : values)
+				s += sum_t(value);
+			return s;
+		}
+		}
+	}
+
+	// Decode the runs of the runlen encoding without expanding them.
+	static void decode_runs(runs &r, src_bytes_t &src, const metadata &meta)
+	{
+		r.resize(meta.nruns);
+		decode_basic(r.values.begin(), r.values.end(), src, meta.run_value_desc);
+		decode_basic(r.ends.begin(), r.ends.end(), src, meta.run_end_desc);
+	}
+
+	// Decode the dictionary of the bitdic encoding. This leaves the source
+	// pointer at the packed codes.
+	static void decode_dictionary(dictionary &dict, src_bytes_t &src, const metadata &meta)
+	{
+		dict.resize(meta.ndistinct);
+		decode_basic(dict.begin(), dict.end(), src, meta.dict_desc);
+	}
+
 private:
+	template <typename I>
+	static bool has_fetch_basic(const detail::encoding_descriptor<I> &desc)
+	{
+		switch (desc.encoding) {
+		case encoding_t::svbyte:
+		case encoding_t::bitpfr:
+		case encoding_t::bitdlt:
+		case encoding_t::bitdod:
+		case encoding_t::runlen:
+		case encoding_t::bitdic:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	template <typename I>
+	static I
+	fetch_basic(src_bytes_t src, size_t index, const detail::encoding_descriptor<I> &desc)
+	{
+		using zigzag_vcodec = zigzag_codec<I>;
+		using origin_vcodec = origin_codec<I>;
+
+		switch (desc.encoding) {
+		case encoding_t::naught:
+			return desc.origin;
+		case encoding_t::normal:
+			return normal_codec<I>::fetch(src, index);
+		case encoding_t::varint:
+			return fetch_skipidx<varint_codec<I, zigzag_vcodec>>(
+				src, index, desc.stride, zigzag_vcodec());
+		case encoding_t::varfor:
+			return fetch_skipidx<varint_codec<I, origin_vcodec>>(
+				src, index, desc.stride, origin_vcodec(desc.origin));
+		case encoding_t::pfxvar:
+			return fetch_skipidx<pfxvar_codec<I, zigzag_vcodec>>(
+				src, index, desc.stride, zigzag_vcodec());
+		case encoding_t::pfxfor:
+			return fetch_skipidx<pfxvar_codec<I, origin_vcodec>>(
+				src, index, desc.stride, origin_vcodec(desc.origin));
+		case encoding_t::bitpck:
+			return bitpck_codec<I>::fetch(src, index, desc.nbits);
+		case encoding_t::bitfor: {
+			typename bitfor_codec<I>::parameters params(desc.origin, desc.nbits);
+			return bitfor_codec<I>::fetch(src, index, params);
+		}
+		case encoding_t::bitvec:
+			return bitvec_codec<I, origin_vcodec>::fetch(
+				src, index, desc.nbits, origin_vcodec(desc.origin));
+		case encoding_t::bitstr:
+			return bitstr_codec<I, origin_vcodec>::fetch(
+				src, index, desc.nbits, origin_vcodec(desc.origin));
+		case encoding_t::bitslc:
+			return bitslc_codec<I, origin_vcodec>::fetch(
+				src, index, desc.nbits, origin_vcodec(desc.origin));
+		case encoding_t::optpfd:
+			return optpfd_codec<I, origin_vcodec>::fetch(
+				src, index, desc.nbits, origin_vcodec(desc.origin));
+		case encoding_t::pagpfr:
+			return pagpfr_codec<I, origin_vcodec>::fetch(
+				src, index, desc.nbits, origin_vcodec(desc.origin));
+		case encoding_t::bitlin: {
+			typename bitlin_codec<I>::parameters params(
+				desc.origin, desc.slope, desc.nbits);
+			return bitlin_codec<I>::fetch(src, index, params);
+		}
+		default:
+			throw std::logic_error("no random access to encoded data");
+		}
+	}
+
+	// Find the run with a given position with a binary search over the
+	// run ends and take its value.
+	static original_t fetch_run(src_bytes_t src, size_t index, const metadata &meta)
+	{
+		const src_bytes_t ends = src + meta.run_value_desc.dataspace;
+		size_t lo = 0, hi = meta.nruns - 1;
+		while (lo < hi) {
+			const size_t mid = (lo + hi) / 2;
+			if (fetch_basic(ends, mid, meta.run_end_desc) > index)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		return fetch_basic(src, lo, meta.run_value_desc);
+	}
+
 	template <typename integer_t>
 	static void compare(detail::encoding_descriptor<integer_t> &desc,
+			    const encoding_cost &cost,
+			    size_t nvalues,
 			    encoding_t encoding,
 			    size_t metaspace,
 			    size_t dataspace,
 			    integer_t origin,
-			    size_t nbits)
+			    size_t nbits,
+			    size_t stride = 0)
 	{
-		if ((dataspace + metaspace) < (desc.dataspace + desc.metaspace)) {
+		if (cost(encoding, dataspace + metaspace, nvalues)
+		    < cost(desc.encoding, desc.dataspace + desc.metaspace, nvalues)) {
 			desc.encoding = encoding;
 			desc.dataspace = dataspace;
 			desc.metaspace = metaspace;
 			desc.origin = origin;
 			desc.nbits = nbits;
+			desc.stride = stride;
 		}
 	}
 
-	template <typename I, typename Iter>
+	// The number of consecutive values in a sample run. It matches the
+	// optpfd chunk so that a run shows the same data as a chunk.
+	static constexpr size_t sample_run = 128;
+
+	// Handle the empty and constant sequences. Returns true if the
+	// sequence is one of these.
+	template <typename I>
+	static bool select_trivial(detail::encoding_descriptor<I> &desc,
+				   const integer_stats<I> &stat)
+	{
+		// An empty sequence.
+		if (stat.nvalues() == 0) {
+			desc.encoding = encoding_t::normal;
+			desc.dataspace = 0;
+			desc.metaspace = 0;
+			return true;
+		}
+
+		// A constant or singular sequence.
+		if (stat.min() == stat.max()) {
+			I value = stat.min();
+			desc.encoding = encoding_t::naught;
+			desc.dataspace = 0;
+			desc.metaspace = varint_codec<I>::value_space(value);
+			desc.origin = value;
+			return true;
+		}
+
+		return false;
+	}
+
+	template <typename I>
 	static void select_basic(detail::encoding_descriptor<I> &desc,
 				 const integer_stats<I> &stat,
-				 Iter src,
-				 Iter const end)
+				 size_t index_stride,
+				 const encoding_cost &cost)
+	{
+		select_packed(desc, stat, cost);
+		// The differences provide no random access just like Stream
+		// VByte.
+		if (!index_stride)
+			select_delta(desc, stat, cost);
+		select_bytes(desc, stat, index_stride, cost);
+	}
+
+	// Select among the encodings which size depends only on the value
+	// range.
+	template <typename I>
+	static void select_packed(detail::encoding_descriptor<I> &desc,
+				  const integer_stats<I> &stat,
+				  const encoding_cost &cost)
 	{
+		using unsigned_t = typename integer_traits<I>::unsigned_t;
 		size_t dataspace, metaspace, nbits;
 
 		//
@@ -455,7 +1435,14 @@ private:
 		dataspace = bitpck_codec<I>::space(stat.nvalues(), nbits);
 
 		// Finally try it.
-		compare(desc, encoding_t::bitpck, 1, dataspace, I{0}, nbits);
+		compare(desc,
+			cost,
+			stat.nvalues(),
+			encoding_t::bitpck,
+			1,
+			dataspace,
+			I{0},
+			nbits);
 
 		//
 		// Compare it against the bit-packed encoding with a frame of
@@ -472,27 +1459,373 @@ private:
 		// The memory required to store the nbits and origin values.
 		metaspace = 1 + varint_codec<I>::value_space(stat.min());
 
-		// Finally try it.
-		compare(desc, encoding_t::bitfor, metaspace, dataspace, stat.min(), nbits);
+		// Try the vertical layout first so that it wins a tie as it
+		// decodes faster.
+		if (nbits <= bitvec_codec<I>::nbits_max) {
+			size_t vecspace = bitvec_codec<I>::space(stat.nvalues(), nbits);
+			compare(desc,
+				cost,
+				stat.nvalues(),
+				encoding_t::bitvec,
+				metaspace,
+				vecspace,
+				stat.min(),
+				nbits);
+		}
 
-		//
-		// Compare it against the varint encoding.
-		//
+		// Then try the horizontal layout.
+		compare(desc,
+			cost,
+			stat.nvalues(),
+			encoding_t::bitfor,
+			metaspace,
+			dataspace,
+			stat.min(),
+			nbits);
+
+		// And finally the continuous bit stream that only has the slack
+		// at the very end. For a multiple of 128 values it takes as much
+		// memory as the vertical layout and loses the tie as it decodes
+		// slower. So it is only picked for other sequence lengths and for
+		// widths above 32 bits.
+		dataspace = bitstr_codec<I>::space(stat.nvalues(), nbits);
+		compare(desc,
+			cost,
+			stat.nvalues(),
+			encoding_t::bitstr,
+			metaspace,
+			dataspace,
+			stat.min(),
+			nbits);
+	}
 
-		// Count the memory footprint of the two kinds of varints.
-		const origin_codec<I> orig(stat.min());
-		size_t vispace = 0, vfspace = 0;
-		for (; src != end; ++src) {
-			original_t val = *src;
-			vispace += varint_codec<I, zigzag_codec<I>>::value_space(val);
-			vfspace += varint_codec<I, origin_codec<I>>::value_space(val, orig);
+	// Select the bit-packed differences between consecutive values if they
+	// take fewer bits than the values. This is the case for sorted or slowly
+	// changing sequences.
+	template <typename I>
+	static void select_delta(detail::encoding_descriptor<I> &desc,
+				 const integer_stats<I> &stat,
+				 const encoding_cost &cost)
+	{
+		using unsigned_t = typename integer_traits<I>::unsigned_t;
+		if (stat.nvalues() < 2)
+			return;
+
+		const unsigned_t range = stat.max() - stat.min();
+		const unsigned_t drange = unsigned_t(stat.delta_max())
+					  - unsigned_t(stat.delta_min());
+		const size_t nbits = integer_traits<unsigned_t>::usedcount(drange);
+		if (nbits >= size_t(integer_traits<unsigned_t>::usedcount(range)))
+			return;
+
+		const I origin = I(stat.delta_min());
+		compare(desc,
+			cost,
+			stat.nvalues(),
+			encoding_t::bitdlt,
+			1 + varint_codec<I>::value_space(origin),
+			bitdlt_codec<I>::space(stat.nvalues(), nbits),
+			origin,
+			nbits);
+	}
+
+	// Select the second differences between consecutive values if the first
+	// ones take fewer bits than the values but still vary. These are the
+	// sequences with nearly constant steps. The second differences are no
+	// wider than the range of the first ones plus the sign bit.
+	template <typename Iter>
+	static void select_second_delta(detail::encoding_descriptor<original_t> &desc,
+					const integer_stats<original_t> &stat,
+					Iter const src,
+					Iter const end,
+					const encoding_cost &cost)
+	{
+		if (stat.nvalues() < 3)
+			return;
+
+		const unsigned_t range = stat.max() - stat.min();
+		const unsigned_t drange = unsigned_t(stat.delta_max())
+					  - unsigned_t(stat.delta_min());
+		const size_t dnbits = integer_traits<unsigned_t>::usedcount(drange);
+		const size_t nbits_max = integer_traits<unsigned_t>::usedcount(range);
+		if (dnbits == 0 || dnbits >= nbits_max)
+			return;
+
+		const size_t nbits = dnbits + 1;
+		compare(desc,
+			cost,
+			stat.nvalues(),
+			encoding_t::bitdod,
+			1,
+			bitdod_codec<original_t>::space(src, end, nbits),
+			original_t(0),
+			nbits);
+	}
+
+	// Select the linear frame-of-reference encoding. It takes one more
+	// pass over the values so it is only tried if the consecutive
+	// differences vary less than the values themselves.
+	template <typename Iter>
+	static void select_linear(detail::encoding_descriptor<original_t> &desc,
+				  const integer_stats<original_t> &stat,
+				  Iter const src,
+				  Iter const end,
+				  const encoding_cost &cost)
+	{
+		if (stat.nvalues() < 3)
+			return;
+
+		const unsigned_t range = stat.max() - stat.min();
+		const size_t nbits = integer_traits<unsigned_t>::usedcount(range);
+		const unsigned_t drange = unsigned_t(stat.delta_max())
+					  - unsigned_t(stat.delta_min());
+		const size_t dnbits = integer_traits<unsigned_t>::usedcount(drange);
+		if (dnbits >= nbits)
+			return;
+
+		using line_codec = bitlin_codec<original_t>;
+		const typename line_codec::parameters params = line_codec::fit(src, end);
+		if (params.nbits >= nbits)
+			return;
+
+		// The memory required to store the nbits, origin and slope values.
+		using signed_t = typename integer_traits<original_t>::signed_t;
+		size_t metaspace = 1 + varint_codec<original_t>::value_space(params.origin);
+		metaspace += varint_codec<signed_t>::value_space(params.slope);
+		compare(desc,
+			cost,
+			stat.nvalues(),
+			encoding_t::bitlin,
+			metaspace,
+			line_codec::space(stat.nvalues(), params.nbits),
+			params.origin,
+			params.nbits);
+		if (desc.encoding == encoding_t::bitlin)
+			desc.slope = params.slope;
+	}
+
+	// Select the runlen encoding if the values make few runs. The run
+	// values and ends get their own basic encodings.
+	template <typename Iter>
+	static void select_runs(metadata &meta,
+				const integer_stats<original_t> &stat,
+				Iter const src,
+				Iter const end,
+				size_t index_stride,
+				const encoding_cost &cost)
+	{
+		const size_t nvalues = stat.nvalues();
+		if (2 * stat.nruns() > nvalues)
+			return;
+
+		runs r;
+		runlen_codec<original_t>::split(r, src, end);
+
+		detail::encoding_descriptor<original_t> value_desc;
+		detail::encoding_descriptor<size_t> end_desc;
+		select_nested(value_desc, r.values.begin(), r.values.end(), index_stride, cost);
+		select_nested(end_desc, r.ends.begin(), r.ends.end(), index_stride, cost);
+
+		// The memory required to store the number of runs, the size of
+		// the run values, and both encodings.
+		using size_codec = varint_codec<size_t>;
+		const size_t metaspace = size_codec::value_space(r.size())
+					 + size_codec::value_space(value_desc.dataspace)
+					 + 1 + value_desc.metaspace + 1 + end_desc.metaspace;
+		const size_t dataspace = value_desc.dataspace + end_desc.dataspace;
+
+		const size_t space = meta.value_desc.dataspace + meta.value_desc.metaspace;
+		const double selected = cost(meta.value_desc.encoding, space, nvalues);
+		if (cost(encoding_t::runlen, metaspace + dataspace, nvalues) < selected) {
+			meta.value_desc.encoding = encoding_t::runlen;
+			meta.value_desc.metaspace = metaspace;
+			meta.value_desc.dataspace = dataspace;
+			meta.value_desc.origin = 0;
+			meta.value_desc.nbits = 0;
+			meta.value_desc.stride = 0;
+
+			meta.nruns = r.size();
+			meta.run_value_desc = value_desc;
+			meta.run_end_desc = end_desc;
 		}
+	}
+
+	// Select the bitdic encoding if the values have few distinct ones. Their
+	// number is estimated first so that the dictionary is only built if the
+	// codes might be narrower than the values relative to the minimum.
+	template <typename Iter>
+	static void select_dictionary(metadata &meta,
+				      const integer_stats<original_t> &stat,
+				      Iter const src,
+				      Iter const end,
+				      size_t index_stride,
+				      const encoding_cost &cost)
+	{
+		using dict_codec = bitdic_codec<original_t>;
+
+		const size_t nvalues = stat.nvalues();
+		const unsigned_t range = stat.max() - stat.min();
+		const size_t nbits = integer_traits<unsigned_t>::usedcount(range);
+		if (nbits < 2 || nvalues < 4)
+			return;
+
+		// The codes take at least a bit each. Stop here if even this is
+		// too much so that the values are not read once more.
+		const size_t space = meta.value_desc.dataspace + meta.value_desc.metaspace;
+		const double selected = cost(meta.value_desc.encoding, space, nvalues);
+		if (cost(encoding_t::bitdic, dict_codec::space(nvalues, 1), nvalues) >= selected)
+			return;
+
+		// A dictionary cannot help if it takes more than half the values
+		// or if the codes take as many bits as the values.
+		const size_t max_nbits = std::min(nbits - 1, size_t(32));
+		const size_t limit = std::min(nvalues / 2, size_t(1) << max_nbits);
+		const size_t estimate = dict_codec::estimate(src, end, limit + 1);
+		if (estimate > limit)
+			return;
+
+		// The codes alone make the lower bound of the encoded size.
+		const size_t estimate_space
+			= dict_codec::space(nvalues, dict_codec::code_nbits(estimate));
+		if (cost(encoding_t::bitdic, estimate_space, nvalues) >= selected)
+			return;
+
+		dictionary dict;
+		dict_codec::build(dict, src, end);
+		const size_t code_nbits = dict_codec::code_nbits(dict.size());
+		if (code_nbits >= nbits)
+			return;
+
+		detail::encoding_descriptor<original_t> dict_desc;
+		select_nested(dict_desc, dict.begin(), dict.end(), index_stride, cost);
+
+		// The memory required to store the code width, the size of the
+		// dictionary, and its encoding.
+		using size_codec = varint_codec<size_t>;
+		const size_t metaspace = 1 + size_codec::value_space(dict.size())
+					 + size_codec::value_space(dict_desc.dataspace) + 1
+					 + dict_desc.metaspace;
+		const size_t dataspace = dict_desc.dataspace
+					 + dict_codec::space(nvalues, code_nbits);
+
+		if (cost(encoding_t::bitdic, metaspace + dataspace, nvalues) < selected) {
+			meta.value_desc.encoding = encoding_t::bitdic;
+			meta.value_desc.metaspace = metaspace;
+			meta.value_desc.dataspace = dataspace;
+			meta.value_desc.origin = 0;
+			meta.value_desc.nbits = code_nbits;
+			meta.value_desc.stride = 0;
+
+			meta.ndistinct = dict.size();
+			meta.dict_desc = dict_desc;
+		}
+	}
+
+	// Select the best basic encoding for an auxiliary sequence.
+	template <typename I, typename Iter>
+	static void select_nested(detail::encoding_descriptor<I> &desc,
+				  Iter const src,
+				  Iter const end,
+				  size_t index_stride,
+				  const encoding_cost &cost)
+	{
+		integer_stats<I> stat(src, end);
+		if (select_trivial(desc, stat))
+			return;
+		stat.build_histogram(src, end);
+		select_basic(desc, stat, index_stride, cost);
+	}
+
+	// Select among the byte-aligned encodings which size depends on the
+	// bit length of every value.
+	template <typename I>
+	static void select_bytes(detail::encoding_descriptor<I> &desc,
+				 const integer_stats<I> &stat,
+				 size_t index_stride,
+				 const encoding_cost &cost)
+	{
+		size_t metaspace;
+
+		// Count the memory footprint of the two kinds of varints, the
+		// two kinds of prefix varints, and the Stream VByte data. All
+		// of them only depend on the value bit lengths so they are taken
+		// from the histograms.
+		size_t vispace = 0, vfspace = 0, pispace = 0, pfspace = 0, svspace = 0;
+		for (size_t nbits = 0; nbits <= integer_traits<I>::nbits; nbits++) {
+			const size_t n = stat.histogram(nbits);
+			const size_t z = stat.zigzag_histogram(nbits);
+			// A zero value still takes a byte.
+			const size_t vnbits = std::max(nbits, size_t(1));
+			vispace += z * varint_codec<I>::nbits_space(vnbits);
+			vfspace += n * varint_codec<I>::nbits_space(vnbits);
+			pispace += z * pfxvar_codec<I>::nbits_space(nbits);
+			pfspace += n * pfxvar_codec<I>::nbits_space(nbits);
+			svspace += n * svbyte_codec<I>::nbits_space(nbits);
+		}
+		svspace += svbyte_codec<I>::control_space(stat.nvalues());
 
 		// The memory required to store the origin value.
 		metaspace = varint_codec<I>::value_space(stat.min());
 
-		compare(desc, encoding_t::varint, 0, vispace, I(0), 0);
-		compare(desc, encoding_t::varfor, metaspace, vfspace, stat.min(), 0);
+		// The memory required for the skip index and its stride value.
+		size_t ixspace = 0, ixmetaspace = 0;
+		if (index_stride) {
+			ixspace = skipidx_codec<varint_codec<I>>::index_space(stat.nvalues(),
+									      index_stride);
+			ixmetaspace = varint_codec<size_t>::value_space(index_stride);
+		}
+
+		// Try the encodings that decode faster first so that they win
+		// a tie. Stream VByte has no skip index so it is not an option
+		// if random access is required.
+		if (!index_stride)
+			compare(desc,
+				cost,
+				stat.nvalues(),
+				encoding_t::svbyte,
+				metaspace,
+				svspace,
+				stat.min(),
+				0);
+		compare(desc,
+			cost,
+			stat.nvalues(),
+			encoding_t::varint,
+			ixmetaspace,
+			vispace + ixspace,
+			I(0),
+			0,
+			index_stride);
+		compare(desc,
+			cost,
+			stat.nvalues(),
+			encoding_t::varfor,
+			metaspace + ixmetaspace,
+			vfspace + ixspace,
+			stat.min(),
+			0,
+			index_stride);
+		// The prefix varints are never larger than the plain ones but
+		// their decoding is serialized on the length of every value so
+		// they are only picked if they are really smaller.
+		compare(desc,
+			cost,
+			stat.nvalues(),
+			encoding_t::pfxvar,
+			ixmetaspace,
+			pispace + ixspace,
+			I(0),
+			0,
+			index_stride);
+		compare(desc,
+			cost,
+			stat.nvalues(),
+			encoding_t::pfxfor,
+			metaspace + ixmetaspace,
+			pfspace + ixspace,
+			stat.min(),
+			0,
+			index_stride);
 	}
 
 	template <typename I, typename Iter>
@@ -503,6 +1836,8 @@ private:
 	{
 		switch (desc.encoding) {
 		case encoding_t::bitpfr:
+		case encoding_t::runlen:
+		case encoding_t::bitdic:
 			throw std::logic_error("not a basic encoding");
 		case encoding_t::naught:
 			naught_codec<I>::encode(dst, src, end);
@@ -511,20 +1846,66 @@ private:
 			normal_codec<I>::encode(dst, src, end);
 			break;
 		case encoding_t::varint:
-			varint_codec<I, zigzag_codec<I>>::encode(dst, src, end);
+			encode_skipidx<varint_codec<I, zigzag_codec<I>>>(
+				dst, src, end, desc.stride, zigzag_codec<I>());
 			break;
 		case encoding_t::varfor:
-			varint_codec<I, origin_codec<I>>::encode(
+			encode_skipidx<varint_codec<I, origin_codec<I>>>(
+				dst, src, end, desc.stride, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::svbyte:
+			svbyte_codec<I, origin_codec<I>>::encode(
 				dst, src, end, origin_codec<I>(desc.origin));
 			break;
+		case encoding_t::pfxvar:
+			encode_skipidx<pfxvar_codec<I, zigzag_codec<I>>>(
+				dst, src, end, desc.stride, zigzag_codec<I>());
+			break;
+		case encoding_t::pfxfor:
+			encode_skipidx<pfxvar_codec<I, origin_codec<I>>>(
+				dst, src, end, desc.stride, origin_codec<I>(desc.origin));
+			break;
 		case encoding_t::bitpck:
 			bitpck_codec<I>::encode(dst, src, end, desc.nbits);
 			break;
-		case encoding_t::bitfor:
+		case encoding_t::bitfor: {
 			typename bitfor_codec<I>::parameters params(desc.origin, desc.nbits);
 			bitfor_codec<I>::encode(dst, src, end, params);
 			break;
 		}
+		case encoding_t::bitvec:
+			bitvec_codec<I, origin_codec<I>>::encode(
+				dst, src, end, desc.nbits, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::bitstr:
+			bitstr_codec<I, origin_codec<I>>::encode(
+				dst, src, end, desc.nbits, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::bitslc:
+			bitslc_codec<I, origin_codec<I>>::encode(
+				dst, src, end, desc.nbits, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::optpfd:
+			optpfd_codec<I, origin_codec<I>>::encode(
+				dst, src, end, desc.nbits, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::pagpfr:
+			pagpfr_codec<I, origin_codec<I>>::encode(
+				dst, src, end, desc.nbits, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::bitdlt:
+			bitdlt_codec<I>::encode(dst, src, end, desc.nbits, desc.origin);
+			break;
+		case encoding_t::bitlin: {
+			typename bitlin_codec<I>::parameters params(
+				desc.origin, desc.slope, desc.nbits);
+			bitlin_codec<I>::encode(dst, src, end, params);
+			break;
+		}
+		case encoding_t::bitdod:
+			bitdod_codec<I>::encode(dst, src, end, desc.nbits);
+			break;
+		}
 	}
 
 	template <typename I, typename Iter>
@@ -535,6 +1916,8 @@ private:
 	{
 		switch (desc.encoding) {
 		case encoding_t::bitpfr:
+		case encoding_t::runlen:
+		case encoding_t::bitdic:
 			throw std::logic_error("not a basic encoding");
 		case encoding_t::naught:
 			naught_codec<I>::decode(dst, end, src, desc.origin);
@@ -543,26 +1926,171 @@ private:
 			normal_codec<I>::decode(dst, end, src);
 			break;
 		case encoding_t::varint:
-			varint_codec<I, zigzag_codec<I>>::decode(dst, end, src);
+			decode_skipidx<varint_codec<I, zigzag_codec<I>>>(
+				dst, end, src, desc.stride, zigzag_codec<I>());
 			break;
 		case encoding_t::varfor:
-			varint_codec<I, origin_codec<I>>::decode(
+			decode_skipidx<varint_codec<I, origin_codec<I>>>(
+				dst, end, src, desc.stride, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::svbyte:
+			svbyte_codec<I, origin_codec<I>>::decode(
 				dst, end, src, origin_codec<I>(desc.origin));
 			break;
+		case encoding_t::pfxvar:
+			decode_skipidx<pfxvar_codec<I, zigzag_codec<I>>>(
+				dst, end, src, desc.stride, zigzag_codec<I>());
+			break;
+		case encoding_t::pfxfor:
+			decode_skipidx<pfxvar_codec<I, origin_codec<I>>>(
+				dst, end, src, desc.stride, origin_codec<I>(desc.origin));
+			break;
 		case encoding_t::bitpck:
 			bitpck_codec<I>::decode(dst, end, src, desc.nbits);
 			break;
-		case encoding_t::bitfor:
+		case encoding_t::bitfor: {
 			typename bitfor_codec<I>::parameters params(desc.origin, desc.nbits);
 			bitfor_codec<I>::decode(dst, end, src, params);
 			break;
 		}
+		case encoding_t::bitvec:
+			bitvec_codec<I, origin_codec<I>>::decode(
+				dst, end, src, desc.nbits, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::bitstr:
+			bitstr_codec<I, origin_codec<I>>::decode(
+				dst, end, src, desc.nbits, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::bitslc:
+			bitslc_codec<I, origin_codec<I>>::decode(
+				dst, end, src, desc.nbits, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::optpfd:
+			optpfd_codec<I, origin_codec<I>>::decode(
+				dst, end, src, desc.nbits, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::pagpfr:
+			pagpfr_codec<I, origin_codec<I>>::decode(
+				dst, end, src, desc.nbits, origin_codec<I>(desc.origin));
+			break;
+		case encoding_t::bitdlt:
+			bitdlt_codec<I>::decode(dst, end, src, desc.nbits, desc.origin);
+			break;
+		case encoding_t::bitlin: {
+			typename bitlin_codec<I>::parameters params(
+				desc.origin, desc.slope, desc.nbits);
+			bitlin_codec<I>::decode(dst, end, src, params);
+			break;
+		}
+		case encoding_t::bitdod:
+			bitdod_codec<I>::decode(dst, end, src, desc.nbits);
+			break;
+		}
+	}
+
+	template <typename C, typename Iter>
+	static void encode_skipidx(dst_bytes_t &dst,
+				   Iter src,
+				   Iter const end,
+				   size_t stride,
+				   typename C::value_codec vcodec)
+	{
+		if (stride)
+			skipidx_codec<C>::encode(dst, src, end, stride, vcodec);
+		else
+			C::encode(dst, src, end, vcodec);
+	}
+
+	template <typename C, typename Iter>
+	static void decode_skipidx(Iter dst,
+				   Iter const end,
+				   src_bytes_t &src,
+				   size_t stride,
+				   typename C::value_codec vcodec)
+	{
+		if (stride)
+			skipidx_codec<C>::decode(dst, end, src, vcodec);
+		else
+			C::decode(dst, end, src, vcodec);
+	}
+
+	template <typename C, typename Iter>
+	static void decode_range_skipidx(Iter dst,
+					 Iter const end,
+					 src_bytes_t src,
+					 size_t first,
+					 size_t stride,
+					 typename C::value_codec vcodec)
+	{
+		if (stride) {
+			skipidx_codec<C>::decode_range(dst, end, src, first, stride, vcodec);
+		} else {
+			C::skip(src, first);
+			C::decode(dst, end, src, vcodec);
+		}
+	}
+
+	template <typename C>
+	static typename C::original_t fetch_skipidx(src_bytes_t src,
+						    size_t index,
+						    size_t stride,
+						    typename C::value_codec vcodec)
+	{
+		if (stride)
+			return skipidx_codec<C>::fetch(src, index, stride, vcodec);
+		C::skip(src, index);
+		return C::value_decode(src, vcodec);
+	}
+
+	// Get the outlier storage of the calling thread.
+	static scratch &thread_scratch()
+	{
+		static thread_local scratch outliers;
+		return outliers;
 	}
 
 	template <typename Iter>
-	static void encode_bitpfr(dst_bytes_t &dst, Iter src, Iter const end, metadata &meta)
+	static void encode_runlen(dst_bytes_t &dst, Iter src, Iter const end, metadata &meta)
 	{
-		typename bitpfr_codec<original_t>::exceptions outliers;
+		runs r;
+		runlen_codec<original_t>::split(r, src, end);
+		encode_basic(dst, r.values.begin(), r.values.end(), meta.run_value_desc);
+		encode_basic(dst, r.ends.begin(), r.ends.end(), meta.run_end_desc);
+	}
+
+	template <typename Iter>
+	static void decode_runlen(Iter dst, Iter const end, src_bytes_t &src, metadata &meta)
+	{
+		runs r;
+		decode_runs(r, src, meta);
+		runlen_codec<original_t>::fill(dst, end, r);
+	}
+
+	template <typename Iter>
+	static void encode_bitdic(dst_bytes_t &dst, Iter src, Iter const end, metadata &meta)
+	{
+		dictionary dict;
+		bitdic_codec<original_t>::build(dict, src, end);
+		encode_basic(dst, dict.begin(), dict.end(), meta.dict_desc);
+		bitdic_codec<original_t>::encode(dst, src, end, dict, meta.value_desc.nbits);
+	}
+
+	template <typename Iter>
+	static void decode_bitdic(Iter dst, Iter const end, src_bytes_t &src, metadata &meta)
+	{
+		dictionary dict;
+		decode_dictionary(dict, src, meta);
+		bitdic_codec<original_t>::decode(dst, end, src, dict, meta.value_desc.nbits);
+	}
+
+	template <typename Iter>
+	static void encode_bitpfr(dst_bytes_t &dst,
+				  Iter src,
+				  Iter const end,
+				  metadata &meta,
+				  scratch &outliers)
+	{
+		outliers.reserve(meta.noutliers);
 
 		// Encode the regular values and collect the outliers info.
 		typename bitpfr_codec<original_t>::parameters params(
@@ -581,13 +2109,14 @@ private:
 	}
 
 	template <typename Iter>
-	static void decode_bitpfr(Iter dst, Iter const end, src_bytes_t &src, metadata &meta)
+	static void decode_bitpfr(Iter dst,
+				  Iter const end,
+				  src_bytes_t &src,
+				  metadata &meta,
+				  scratch &outliers)
 	{
-		typename bitpfr_codec<original_t>::exceptions outliers;
-
 		// Prepare the outliers storage.
-		outliers.indices.resize(meta.noutliers);
-		outliers.values.resize(meta.noutliers);
+		outliers.resize(meta.noutliers);
 
 		// Decode the regular values.
 		typename bitpfr_codec<original_t>::parameters params(
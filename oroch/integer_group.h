@@ -24,6 +24,7 @@
 #ifndef OROCH_INTEGER_GROUP_H_
 #define OROCH_INTEGER_GROUP_H_
 
+#include <iterator>
 #include <memory>
 
 #include "common.h"
@@ -42,11 +43,17 @@ public:
 	static constexpr size_t alignment_mask = alignment - 1;
 
 	template <typename Iter>
-	void encode(Iter begin, Iter const end, bool aligned = true)
+	void encode(Iter begin, Iter const end, bool aligned = true, size_t index_stride = 0)
 	{
 		typename codec::metadata meta;
-		codec::select(meta, begin, end);
+		codec::select(meta, begin, end, index_stride);
+		encode(begin, end, meta, aligned);
+	}
 
+	// Encode the values with an already selected encoding.
+	template <typename Iter>
+	void encode(Iter begin, Iter const end, typename codec::metadata &meta, bool aligned = true)
+	{
 		size_t offset = meta.metaspace();
 		if (aligned)
 			offset = (offset + alignment_mask) & ~alignment_mask;
@@ -63,6 +70,22 @@ public:
 	void decode(Iter begin, Iter const end, bool aligned = true) const
 	{
 		typename codec::metadata meta;
+		src_bytes_t data_bytes = decode(meta, aligned);
+		codec::decode(begin, end, data_bytes, meta);
+	}
+
+	// Get the memory required for a group with a given encoding.
+	static size_t space(const typename codec::metadata &meta, bool aligned = true)
+	{
+		size_t offset = meta.metaspace();
+		if (aligned)
+			offset = (offset + alignment_mask) & ~alignment_mask;
+		return offset + meta.dataspace();
+	}
+
+	// Decode the metadata and get the start of the encoded data.
+	src_bytes_t decode(typename codec::metadata &meta, bool aligned = true) const
+	{
 		src_bytes_t meta_bytes = data_.get();
 		src_bytes_t meta_start = meta_bytes;
 		meta.decode(meta_bytes);
@@ -71,14 +94,30 @@ public:
 		if (aligned)
 			offset = (offset + alignment_mask) & ~alignment_mask;
 
-		src_bytes_t data_bytes = data_.get() + offset;
-		codec::decode(begin, end, data_bytes, meta);
+		return data_.get() + offset;
 	}
 
-	void decode(typename codec::metadata &meta) const
+	// Fetch a single value. This requires an encoding that supports
+	// random access (see integer_codec::has_fetch).
+	original_t fetch(size_t index, bool aligned = true) const
 	{
-		src_bytes_t meta_bytes = data_.get();
-		meta.decode(meta_bytes);
+		typename codec::metadata meta;
+		src_bytes_t data_bytes = decode(meta, aligned);
+		return codec::fetch(data_bytes, index, meta);
+	}
+
+	// Decode the values from the first to the last position (exclusive).
+	// This requires an encoding that supports random access (see
+	// integer_codec::has_fetch).
+	template <typename Iter>
+	void decode_range(size_t first, size_t last, Iter out, bool aligned = true) const
+	{
+		typename codec::metadata meta;
+		src_bytes_t data_bytes = decode(meta, aligned);
+
+		Iter end = out;
+		std::advance(end, last - first);
+		codec::decode_range(out, end, data_bytes, first, meta);
 	}
 
 protected:
@@ -25,18 +25,200 @@
 #define OROCH_INTEGER_STATS_H_
 
 #include <array>
+#include <cstdint>
 #include <limits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #include "common.h"
 #include "integer_traits.h"
+#include "varint.h"
+#include "zigzag.h"
 
 namespace oroch {
 
+namespace detail {
+
+// Check if an iterator refers to values stored contiguously in memory.
+template <typename Iter, typename T>
+struct is_contiguous
+{
+	static constexpr bool value
+		= std::is_same<Iter, T *>::value || std::is_same<Iter, const T *>::value
+		  || std::is_same<Iter, typename std::vector<T>::iterator>::value
+		  || std::is_same<Iter, typename std::vector<T>::const_iterator>::value;
+};
+
+#if defined(__AVX2__)
+
+// Vector min and max operations for integers of a given size and sign.
+template <size_t size, bool is_signed>
+struct stats_lanes;
+
+template <>
+struct stats_lanes<1, true>
+{
+	static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi8(a, b); }
+	static __m256i max(__m256i a, __m256i b) { return _mm256_max_epi8(a, b); }
+};
+
+template <>
+struct stats_lanes<1, false>
+{
+	static __m256i min(__m256i a, __m256i b) { return _mm256_min_epu8(a, b); }
+	static __m256i max(__m256i a, __m256i b) { return _mm256_max_epu8(a, b); }
+};
+
+template <>
+struct stats_lanes<2, true>
+{
+	static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi16(a, b); }
+	static __m256i max(__m256i a, __m256i b) { return _mm256_max_epi16(a, b); }
+};
+
+template <>
+struct stats_lanes<2, false>
+{
+	static __m256i min(__m256i a, __m256i b) { return _mm256_min_epu16(a, b); }
+	static __m256i max(__m256i a, __m256i b) { return _mm256_max_epu16(a, b); }
+};
+
+template <>
+struct stats_lanes<4, true>
+{
+	static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi32(a, b); }
+	static __m256i max(__m256i a, __m256i b) { return _mm256_max_epi32(a, b); }
+};
+
+template <>
+struct stats_lanes<4, false>
+{
+	static __m256i min(__m256i a, __m256i b) { return _mm256_min_epu32(a, b); }
+	static __m256i max(__m256i a, __m256i b) { return _mm256_max_epu32(a, b); }
+};
+
+template <>
+struct stats_lanes<8, true>
+{
+#if defined(__AVX512VL__)
+	static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi64(a, b); }
+	static __m256i max(__m256i a, __m256i b) { return _mm256_max_epi64(a, b); }
+#else
+	static __m256i min(__m256i a, __m256i b)
+	{
+		return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+	}
+	static __m256i max(__m256i a, __m256i b)
+	{
+		return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+	}
+#endif
+};
+
+template <>
+struct stats_lanes<8, false>
+{
+#if defined(__AVX512VL__)
+	static __m256i min(__m256i a, __m256i b) { return _mm256_min_epu64(a, b); }
+	static __m256i max(__m256i a, __m256i b) { return _mm256_max_epu64(a, b); }
+#else
+	// Flip the sign bits to compare as signed.
+	static __m256i greater(__m256i a, __m256i b)
+	{
+		const __m256i sign = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+		return _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign));
+	}
+	static __m256i min(__m256i a, __m256i b)
+	{
+		return _mm256_blendv_epi8(a, b, greater(a, b));
+	}
+	static __m256i max(__m256i a, __m256i b)
+	{
+		return _mm256_blendv_epi8(b, a, greater(a, b));
+	}
+#endif
+};
+
+// Subtract integers of a given size.
+template <size_t size>
+inline __m256i
+stats_sub(__m256i a, __m256i b)
+{
+	if constexpr (size == 1)
+		return _mm256_sub_epi8(a, b);
+	else if constexpr (size == 2)
+		return _mm256_sub_epi16(a, b);
+	else if constexpr (size == 4)
+		return _mm256_sub_epi32(a, b);
+	else
+		return _mm256_sub_epi64(a, b);
+}
+
+// Count the equal integers of a given size.
+template <size_t size>
+inline size_t
+stats_equal(__m256i a, __m256i b)
+{
+	__m256i eq;
+	if constexpr (size == 1)
+		eq = _mm256_cmpeq_epi8(a, b);
+	else if constexpr (size == 2)
+		eq = _mm256_cmpeq_epi16(a, b);
+	else if constexpr (size == 4)
+		eq = _mm256_cmpeq_epi32(a, b);
+	else
+		eq = _mm256_cmpeq_epi64(a, b);
+	return __builtin_popcount(unsigned(_mm256_movemask_epi8(eq))) / size;
+}
+
+// Get the number of used bits in 32-bit lanes.
+inline __m256i
+stats_usedcount32(__m256i x)
+{
+#if defined(__AVX512CD__) && defined(__AVX512VL__)
+	return _mm256_sub_epi32(_mm256_set1_epi32(32), _mm256_lzcnt_epi32(x));
+#else
+	// Take the exponent of the value converted to float. Every bit next
+	// to a higher set bit is cleared first so that rounding never reaches
+	// the next power of two. The conversion is signed so the value is
+	// halved too. That loses the 0 and 1 values which are taken as is.
+	x = _mm256_andnot_si256(_mm256_srli_epi32(x, 1), x);
+	const __m256i f = _mm256_castps_si256(_mm256_cvtepi32_ps(_mm256_srli_epi32(x, 1)));
+	const __m256i n = _mm256_sub_epi32(_mm256_srli_epi32(f, 23), _mm256_set1_epi32(125));
+	return _mm256_max_epi32(n, _mm256_min_epu32(x, _mm256_set1_epi32(1)));
+#endif
+}
+
+// Get the number of used bits in 64-bit lanes.
+inline __m256i
+stats_usedcount64(__m256i x)
+{
+#if defined(__AVX512CD__) && defined(__AVX512VL__)
+	return _mm256_sub_epi64(_mm256_set1_epi64x(64), _mm256_lzcnt_epi64(x));
+#else
+	// Combine the counts for the low and high halves.
+	const __m256i n = stats_usedcount32(x);
+	const __m256i lo = _mm256_and_si256(n, _mm256_set1_epi64x(0xffffffff));
+	const __m256i hi = _mm256_srli_epi64(n, 32);
+	const __m256i hi_zero = _mm256_cmpeq_epi64(hi, _mm256_setzero_si256());
+	return _mm256_blendv_epi8(_mm256_add_epi64(hi, _mm256_set1_epi64x(32)), lo, hi_zero);
+#endif
+}
+
+#endif
+
+} // namespace oroch::detail
+
 template <typename T>
 class integer_stats
 {
 public:
 	using original_t = T;
+	using signed_t = typename integer_traits<original_t>::signed_t;
 	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
 
 	static constexpr size_t nbits = integer_traits<original_t>::nbits;
@@ -44,12 +226,24 @@ public:
 	// Collect basic sequence info:
 	//  * the number of values;
 	//  * the minimum value;
-	//  * the maximum value.
+	//  * the maximum value;
+	//  * the minimum and maximum difference between consecutive values;
+	//  * the number of runs of equal values.
 	template <typename Iter>
 	integer_stats(Iter src, Iter const end)
 	{
-		for (; src != end; ++src)
-			add(*src);
+		if constexpr (detail::is_contiguous<Iter, original_t>::value) {
+			if (src != end)
+				add_all(&*src, std::distance(src, end));
+		} else if (src != end) {
+			original_t previous = *src++;
+			add(previous);
+			for (; src != end; ++src) {
+				add_delta(*src, previous);
+				add(*src);
+				previous = *src;
+			}
+		}
 	}
 
 	size_t nvalues() const
@@ -65,18 +259,86 @@ public:
 		return maxvalue_;
 	}
 
+	// Get the smallest and largest differences between consecutive values.
+	// They wrap around and are taken as signed. There are no differences
+	// unless there are at least two values.
+	signed_t delta_min() const
+	{
+		return mindelta_;
+	}
+	signed_t delta_max() const
+	{
+		return maxdelta_;
+	}
+
+	size_t nruns() const
+	{
+		return nvalues_ - nequal_;
+	}
+
 	size_t original_space() const
 	{
 		return nvalues() * sizeof(original_t);
 	}
 
-	// Collect info for bit-length histogram of values.
+	// Collect info for bit-length histograms of values. There are two of
+	// them, one for the values relative to the minimum and the other for
+	// the zigzag-encoded values. These provide the memory footprint of all
+	// the byte-aligned encodings.
 	template <typename Iter>
 	void build_histogram(Iter src, Iter const end)
 	{
-		// Build the histogram.
-		for (; src != end; ++src)
-			stat(*src);
+		if constexpr (detail::is_contiguous<Iter, original_t>::value) {
+			if (src != end)
+				stat_all(&*src, std::distance(src, end));
+		} else {
+			for (; src != end; ++src)
+				stat(*src);
+		}
+	}
+
+	// Collect info on outlier indices for bitpfr encoding with every
+	// possible bit width of regular values in a single pass.
+	//
+	// A value is an outlier for every regular value width below its own
+	// width. The previous outliers are kept on a stack with their widths
+	// decreasing to the top. The previous outlier for a width is the
+	// topmost one that is wider. So the widths are split into a few ranges
+	// each with the same gap. The entries that are not wider than the new
+	// outlier are no longer needed. Thus every value takes only a few steps
+	// regardless of the number of bits.
+	template <typename Iter>
+	void build_outlier_index(Iter src, Iter const end)
+	{
+		// The bottom of the stack is the start of the sequence that is
+		// wider than any value.
+		outlier stack[nbits + 2];
+		stack[0] = {0, nbits + 1};
+		size_t depth = 1;
+
+		for (size_t position = 0; src != end; ++src, ++position) {
+			unsigned_t delta = *src - minvalue_;
+			size_t width = integer_traits<unsigned_t>::usedcount(delta);
+			if (width == 0)
+				continue;
+
+			size_t lo = 0;
+			for (;;) {
+				const outlier &top = stack[depth - 1];
+				const size_t hi = top.width < width ? top.width : width;
+				if (lo < hi)
+					stat_gap(lo, hi, position - top.base);
+				if (top.width > width)
+					break;
+				lo = top.width;
+				depth--;
+			}
+			stack[depth++] = {position + 1, width};
+		}
+
+		// Sum up the index space deltas.
+		for (size_t i = 1; i <= nbits; i++)
+			index_space_[i] += index_space_[i - 1];
 	}
 
 	size_t histogram(std::size_t index) const
@@ -84,6 +346,34 @@ public:
 		return histogram_[index];
 	}
 
+	// Get the number of values of a given bit length after zigzag encoding
+	// of the signed values or as is for the unsigned ones.
+	size_t zigzag_histogram(std::size_t index) const
+	{
+		return zigzag_histogram_[index];
+	}
+
+	// Get the memory required to varint-encode outlier indices if regular
+	// values take a given number of bits. An index is encoded as the gap
+	// after the previous outlier.
+	size_t outlier_index_space(std::size_t index) const
+	{
+		return index_space_[index];
+	}
+
+	// Get the number of bits required to bit-pack outlier indices if
+	// regular values take a given number of bits.
+	size_t outlier_index_nbits(std::size_t index) const
+	{
+		if (index >= 64)
+			return 0;
+		for (size_t n = index_gap_.size() - 1; n > 0; n--) {
+			if ((index_gap_[n] >> index) & 1)
+				return n;
+		}
+		return 0;
+	}
+
 private:
 	void add(original_t value)
 	{
@@ -94,11 +384,234 @@ private:
 			maxvalue_ = value;
 	}
 
+	void add_delta(original_t value, original_t previous)
+	{
+		const signed_t delta = signed_t(unsigned_t(value) - unsigned_t(previous));
+		if (mindelta_ > delta)
+			mindelta_ = delta;
+		if (maxdelta_ < delta)
+			maxdelta_ = delta;
+		if (delta == 0)
+			nequal_++;
+	}
+
 	void stat(original_t value)
 	{
 		unsigned_t delta = value - minvalue_;
 		size_t index = integer_traits<unsigned_t>::usedcount(delta);
 		histogram_[index]++;
+
+		unsigned_t zigzag = zigzag_codec<original_t>::encode_if_signed(value);
+		zigzag_histogram_[integer_traits<unsigned_t>::usedcount(zigzag)]++;
+	}
+
+	// Find the minimum and maximum of values stored contiguously along with
+	// the differences between them. The differences for a vector are taken
+	// against the same vector loaded one value back.
+	void add_all(const original_t *src, const size_t n)
+	{
+		size_t i = 0;
+#if defined(__AVX2__)
+		using lanes = detail::stats_lanes<sizeof(original_t),
+						  std::is_signed<original_t>::value>;
+		using dlanes = detail::stats_lanes<sizeof(original_t), true>;
+		constexpr size_t nlanes = sizeof(__m256i) / sizeof(original_t);
+		if (n >= 2 * nlanes) {
+			// Keep a few independent accumulators to hide latency.
+			constexpr size_t nacc = 2;
+			const __m256i *vsrc = reinterpret_cast<const __m256i *>(src);
+			// The vectors from the second one on shifted back by a value.
+			const __m256i *psrc
+				= reinterpret_cast<const __m256i *>(src + nlanes - 1);
+			__m256i vmin[nacc], vmax[nacc], dmin[nacc], dmax[nacc];
+			size_t nequal = 0;
+			const __m256i d0 = detail::stats_sub<sizeof(original_t)>(
+				_mm256_loadu_si256(vsrc + 1), _mm256_loadu_si256(psrc));
+#pragma GCC unroll 4
+			for (size_t a = 0; a < nacc; a++) {
+				vmin[a] = vmax[a] = _mm256_loadu_si256(vsrc);
+				dmin[a] = dmax[a] = d0;
+			}
+
+			const size_t nvectors = n / nlanes;
+			size_t v = 1;
+			for (; v + nacc <= nvectors; v += nacc) {
+#pragma GCC unroll 4
+				for (size_t a = 0; a < nacc; a++) {
+					const __m256i x = _mm256_loadu_si256(vsrc + v + a);
+					const __m256i p = _mm256_loadu_si256(psrc + v - 1 + a);
+					const __m256i d
+						= detail::stats_sub<sizeof(original_t)>(x, p);
+					vmin[a] = lanes::min(vmin[a], x);
+					vmax[a] = lanes::max(vmax[a], x);
+					dmin[a] = dlanes::min(dmin[a], d);
+					dmax[a] = dlanes::max(dmax[a], d);
+					nequal += detail::stats_equal<sizeof(original_t)>(x, p);
+				}
+			}
+			for (; v < nvectors; v++) {
+				const __m256i x = _mm256_loadu_si256(vsrc + v);
+				const __m256i p = _mm256_loadu_si256(psrc + v - 1);
+				const __m256i d = detail::stats_sub<sizeof(original_t)>(x, p);
+				vmin[0] = lanes::min(vmin[0], x);
+				vmax[0] = lanes::max(vmax[0], x);
+				dmin[0] = dlanes::min(dmin[0], d);
+				dmax[0] = dlanes::max(dmax[0], d);
+				nequal += detail::stats_equal<sizeof(original_t)>(x, p);
+			}
+#pragma GCC unroll 4
+			for (size_t a = 1; a < nacc; a++) {
+				vmin[0] = lanes::min(vmin[0], vmin[a]);
+				vmax[0] = lanes::max(vmax[0], vmax[a]);
+				dmin[0] = dlanes::min(dmin[0], dmin[a]);
+				dmax[0] = dlanes::max(dmax[0], dmax[a]);
+			}
+			i = nvectors * nlanes;
+
+			original_t lmin[nlanes], lmax[nlanes];
+			signed_t ldmin[nlanes], ldmax[nlanes];
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(lmin), vmin[0]);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(lmax), vmax[0]);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(ldmin), dmin[0]);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(ldmax), dmax[0]);
+			for (size_t k = 0; k < nlanes; k++) {
+				if (minvalue_ > lmin[k])
+					minvalue_ = lmin[k];
+				if (maxvalue_ < lmax[k])
+					maxvalue_ = lmax[k];
+				if (mindelta_ > ldmin[k])
+					mindelta_ = ldmin[k];
+				if (maxdelta_ < ldmax[k])
+					maxdelta_ = ldmax[k];
+			}
+			nvalues_ += i;
+			nequal_ += nequal;
+
+			// The differences within the first vector.
+			for (size_t k = 1; k < nlanes; k++)
+				add_delta(src[k], src[k - 1]);
+		}
+#endif
+		if (i == 0)
+			add(src[i++]);
+		for (; i < n; i++) {
+			add_delta(src[i], src[i - 1]);
+			add(src[i]);
+		}
+	}
+
+	// Build the histograms of values stored contiguously. The counts are
+	// spread over a few histograms in turn so that a run of values of the
+	// same width does not wait on the same counter over and over.
+	void stat_all(const original_t *src, const size_t n)
+	{
+		size_t counts[nways][nbits + 1] = {};
+		size_t zcounts[nways][nbits + 1] = {};
+
+		size_t i = 0;
+#if defined(__AVX2__)
+		if constexpr (sizeof(original_t) == 8) {
+			const __m256i *vsrc = reinterpret_cast<const __m256i *>(src);
+			const __m256i vmin = _mm256_set1_epi64x(int64_t(minvalue_));
+			for (; i + 4 <= n; i += 4) {
+				const __m256i x = _mm256_loadu_si256(vsrc + i / 4);
+				__m256i z = x;
+				if constexpr (std::is_signed<original_t>::value) {
+					const __m256i zero = _mm256_setzero_si256();
+					const __m256i sign = _mm256_cmpgt_epi64(zero, x);
+					z = _mm256_xor_si256(_mm256_slli_epi64(x, 1), sign);
+				}
+				const __m256i d = _mm256_sub_epi64(x, vmin);
+				count_lanes64(counts, detail::stats_usedcount64(d));
+				count_lanes64(zcounts, detail::stats_usedcount64(z));
+			}
+		} else {
+			// Extend the values to 32-bit lanes.
+			constexpr bool is_signed = std::is_signed<original_t>::value;
+			const __m256i vmin = _mm256_set1_epi32(int32_t(minvalue_));
+			for (; i + 8 <= n; i += 8) {
+				const __m128i *in = reinterpret_cast<const __m128i *>(src + i);
+				__m256i x;
+				if constexpr (sizeof(original_t) == 1) {
+					const __m128i v = _mm_loadl_epi64(in);
+					x = is_signed ? _mm256_cvtepi8_epi32(v)
+						      : _mm256_cvtepu8_epi32(v);
+				} else if constexpr (sizeof(original_t) == 2) {
+					const __m128i v = _mm_loadu_si128(in);
+					x = is_signed ? _mm256_cvtepi16_epi32(v)
+						      : _mm256_cvtepu16_epi32(v);
+				} else {
+					x = _mm256_loadu_si256(
+						reinterpret_cast<const __m256i *>(in));
+				}
+				__m256i z = x;
+				if constexpr (is_signed)
+					z = _mm256_xor_si256(_mm256_slli_epi32(x, 1),
+							     _mm256_srai_epi32(x, 31));
+				const __m256i d = _mm256_sub_epi32(x, vmin);
+				count_lanes32(counts, detail::stats_usedcount32(d));
+				count_lanes32(zcounts, detail::stats_usedcount32(z));
+			}
+		}
+#endif
+		for (; i < n; i++) {
+			using zigzag_t = zigzag_codec<original_t>;
+			const unsigned_t delta = src[i] - minvalue_;
+			const unsigned_t zigzag = zigzag_t::encode_if_signed(src[i]);
+			counts[i % nways][integer_traits<unsigned_t>::usedcount(delta)]++;
+			zcounts[i % nways][integer_traits<unsigned_t>::usedcount(zigzag)]++;
+		}
+
+		for (size_t w = 0; w < nways; w++) {
+			for (size_t k = 0; k <= nbits; k++) {
+				histogram_[k] += counts[w][k];
+				zigzag_histogram_[k] += zcounts[w][k];
+			}
+		}
+	}
+
+	// The number of interleaved histograms for contiguous values.
+	static constexpr size_t nways = 4;
+
+#if defined(__AVX2__)
+	// Count the widths in the 32-bit lanes of a vector. The lanes are
+	// taken straight out of the register as a store and a reload stall.
+	static void count_lanes32(size_t (*counts)[nbits + 1], const __m256i x)
+	{
+		const __m128i lo = _mm256_castsi256_si128(x);
+		const __m128i hi = _mm256_extracti128_si256(x, 1);
+		counts[0][_mm_cvtsi128_si32(lo)]++;
+		counts[1][_mm_extract_epi32(lo, 1)]++;
+		counts[2][_mm_extract_epi32(lo, 2)]++;
+		counts[3][_mm_extract_epi32(lo, 3)]++;
+		counts[0][_mm_cvtsi128_si32(hi)]++;
+		counts[1][_mm_extract_epi32(hi, 1)]++;
+		counts[2][_mm_extract_epi32(hi, 2)]++;
+		counts[3][_mm_extract_epi32(hi, 3)]++;
+	}
+
+	// Count the widths in the 64-bit lanes of a vector.
+	static void count_lanes64(size_t (*counts)[nbits + 1], const __m256i x)
+	{
+		const __m128i lo = _mm256_castsi256_si128(x);
+		const __m128i hi = _mm256_extracti128_si256(x, 1);
+		counts[0][_mm_cvtsi128_si64(lo)]++;
+		counts[1][_mm_extract_epi64(lo, 1)]++;
+		counts[2][_mm_cvtsi128_si64(hi)]++;
+		counts[3][_mm_extract_epi64(hi, 1)]++;
+	}
+#endif
+
+	// Account an outlier index gap for a range of regular value widths.
+	void stat_gap(size_t lo, size_t hi, size_t gap)
+	{
+		const size_t space = varint_codec<size_t>::value_space(gap);
+		index_space_[lo] += space;
+		index_space_[hi] -= space;
+
+		// Mark the widths from lo to hi for the gap length.
+		const uint64_t widths = (hi < 64 ? uint64_t(1) << hi : 0) - (uint64_t(1) << lo);
+		index_gap_[integer_traits<size_t>::usedcount(gap)] |= widths;
 	}
 
 	// The total number of values.
@@ -108,8 +621,32 @@ private:
 	original_t minvalue_ = std::numeric_limits<original_t>::max();
 	original_t maxvalue_ = std::numeric_limits<original_t>::min();
 
-	// The log2 histogram of values.
+	// The minimum and maximum differences between consecutive values.
+	signed_t mindelta_ = std::numeric_limits<signed_t>::max();
+	signed_t maxdelta_ = std::numeric_limits<signed_t>::min();
+	// The number of values equal to the previous ones.
+	size_t nequal_ = 0;
+
+	// The log2 histogram of values relative to the minimum.
 	std::array<size_t, nbits + 1> histogram_ = {};
+	// The log2 histogram of zigzag-encoded values.
+	std::array<size_t, nbits + 1> zigzag_histogram_ = {};
+
+	// The outlier index space by the width of regular values. While
+	// collecting the info it holds the deltas against the previous width.
+	std::array<size_t, nbits + 1> index_space_ = {};
+	// The widths of regular values for which there are outlier index gaps
+	// of a given bit length. A width is a bit in a mask.
+	std::array<uint64_t, integer_traits<size_t>::nbits + 1> index_gap_ = {};
+
+	// An entry of the stack of previous outliers.
+	struct outlier
+	{
+		// The position right after the outlier.
+		size_t base;
+		// The outlier width.
+		size_t width;
+	};
 };
 
 } // namespace oroch
@@ -56,6 +56,11 @@ public:
 			src += sizeof(original_t);
 		}
 	}
+
+	static original_t fetch(src_bytes_t src, const size_t index)
+	{
+		return reinterpret_cast<const original_t *>(src)[index];
+	}
 };
 
 } // namespace oroch
@@ -48,7 +48,7 @@ public:
 	using original_t = T;
 	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
 
-	offset_codec(original_t origin) : origin_{origin + (taken_out ? offset : 0)}
+	offset_codec(original_t origin) : origin_(origin + (taken_out ? offset : 0))
 	{
 	}
 
@@ -0,0 +1,314 @@
+// optpfd.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_OPTPFD_H_
+#define OROCH_OPTPFD_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include "bitpck.h"
+#include "common.h"
+#include "integer_traits.h"
+#include "zigzag.h"
+
+namespace oroch {
+
+//
+// Patched bit-packing with inline exceptions in the spirit of the NewPFD and
+// OptPFD schemes described in "Inverted Index Compression and Query Processing
+// with Optimized Document Ordering" by Hao Yan, Shuai Ding, and Torsten Suel.
+//
+// Integers are split into chunks of 128. Every chunk has its own bit width
+// chosen to minimize the chunk size. The integers that do not fit the width
+// are exceptions. Their low bits are packed along with the regular integers
+// and their high bits are stored right before that. A chunk is laid out as
+// follows:
+//
+//   * the bit width,
+//   * the number of exceptions,
+//   * the exception positions within the chunk, a byte each,
+//   * the exception high bits packed into a bit stream,
+//   * the low bits of all the integers packed as with bitpck_codec.
+//
+// The high bits of exceptions take up to a given maximum width less the
+// chunk width. This maximum width is the only parameter of the codec in
+// addition to the value code.
+//
+// The exceptions are patched in a small buffer right after the chunk is
+// unpacked. Random access skips over the preceding chunks one by one using
+// their headers.
+//
+// By default the codec applies zigzag encoding if used on signed types.
+// This can be replaced by supplying a different value code explicitly.
+//
+template <typename T, typename V = zigzag_codec<T>>
+class optpfd_codec
+{
+public:
+	using original_t = T;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+	using value_codec = V;
+
+	static constexpr size_t chunk_capacity = 128;
+
+	// Get the number of bytes required to encode a given integer sequence.
+	template <typename Iter>
+	static size_t
+	space(Iter src, Iter const end, const size_t nbits, value_codec vcodec = value_codec())
+	{
+		size_t count = 0;
+		while (src != end) {
+			unsigned_t buffer[chunk_capacity];
+			const size_t m = chunk_fill(buffer, src, end, vcodec);
+			size_t chunk_nbits;
+			count += chunk_space(chunk_nbits, buffer, m, nbits);
+		}
+		return count;
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst,
+			   Iter src,
+			   Iter const end,
+			   const size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		while (src != end) {
+			unsigned_t buffer[chunk_capacity];
+			const size_t m = chunk_fill(buffer, src, end, vcodec);
+			size_t chunk_nbits;
+			chunk_space(chunk_nbits, buffer, m, nbits);
+
+			const size_t xnbits = nbits - chunk_nbits;
+			const uint64_t mask = uint64_t(int64_t(-1)) >> (64 - chunk_nbits);
+
+			dst_bytes_t header = dst;
+			dst += 2;
+			size_t count = 0;
+			for (size_t i = 0; i < m; i++) {
+				if ((buffer[i] & ~mask) != 0) {
+					*dst++ = byte_t(i);
+					count++;
+				}
+			}
+			header[0] = byte_t(chunk_nbits);
+			header[1] = byte_t(count);
+
+			dst_bytes_t xbits = dst;
+			std::memset(xbits, 0, xspace(count, xnbits));
+			for (size_t i = 0, j = 0; i < m; i++) {
+				if ((buffer[i] & ~mask) == 0)
+					continue;
+				const uint64_t x = buffer[i] >> chunk_nbits;
+				put_bits(xbits, j++ * xnbits, x, xnbits);
+			}
+			dst += xspace(count, xnbits);
+
+			bitpck_codec<unsigned_t>::encode(dst, buffer, buffer + m, chunk_nbits);
+		}
+	}
+
+	template <typename Iter>
+	static void decode(Iter dst,
+			   Iter const end,
+			   src_bytes_t &src,
+			   const size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		for (auto n = std::distance(dst, end); n > 0; n -= chunk_capacity) {
+			const size_t m = std::min(size_t(n), chunk_capacity);
+			unsigned_t buffer[chunk_capacity];
+			chunk_decode(buffer, m, src, nbits);
+			for (size_t i = 0; i < m; i++)
+				*dst++ = vcodec.value_decode(buffer[i]);
+		}
+	}
+
+	static original_t fetch(src_bytes_t src,
+				const size_t index,
+				const size_t nbits,
+				value_codec vcodec = value_codec())
+	{
+		src = seek(src, index / chunk_capacity, nbits);
+
+		const size_t chunk_nbits = src[0];
+		const size_t count = src[1];
+		const src_bytes_t positions = src + 2;
+		const src_bytes_t xbits = positions + count;
+		const size_t xnbits = nbits - chunk_nbits;
+		const size_t i = index % chunk_capacity;
+
+		unsigned_t value = bitpck_codec<unsigned_t>::fetch(
+			xbits + xspace(count, xnbits), i, chunk_nbits);
+		const void *position = std::memchr(positions, int(i), count);
+		if (position != nullptr) {
+			const size_t j = static_cast<src_bytes_t>(position) - positions;
+			value |= unsigned_t(get_bits(xbits, j * xnbits, xnbits)) << chunk_nbits;
+		}
+		return vcodec.value_decode(value);
+	}
+
+	// Decode integers starting from a given position. The decoding starts
+	// right at the chunk that contains the first requested integer.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const size_t nbits,
+				 value_codec vcodec = value_codec())
+	{
+		src = seek(src, first / chunk_capacity, nbits);
+
+		// Take the integers from a partially requested chunk.
+		size_t index = first % chunk_capacity;
+		if (index && dst != end) {
+			unsigned_t buffer[chunk_capacity];
+			const size_t m = std::min(size_t(std::distance(dst, end)) + index,
+						  chunk_capacity);
+			chunk_decode(buffer, m, src, nbits);
+			for (; index < m; index++)
+				*dst++ = vcodec.value_decode(buffer[index]);
+		}
+
+		decode(dst, end, src, nbits, vcodec);
+	}
+
+private:
+	// Get the number of bytes required for the high bits of exceptions.
+	static constexpr size_t xspace(size_t count, size_t xnbits)
+	{
+		return (count * xnbits + 7) / 8;
+	}
+
+	template <typename Iter>
+	static size_t
+	chunk_fill(unsigned_t *buffer, Iter &src, Iter const end, value_codec &vcodec)
+	{
+		size_t m = 0;
+		for (; m < chunk_capacity && src != end; m++)
+			buffer[m] = vcodec.value_encode(*src++);
+		return m;
+	}
+
+	// Choose the bit width for a chunk. For every width the number of
+	// exceptions is found with a histogram of the integer widths. The
+	// widest of the best choices is taken as it has fewer exceptions to
+	// patch. Returns the chunk size.
+	static size_t chunk_space(size_t &chunk_nbits,
+				  const unsigned_t *buffer,
+				  const size_t m,
+				  const size_t nbits)
+	{
+		size_t histogram[64 + 1] = {};
+		for (size_t i = 0; i < m; i++)
+			histogram[integer_traits<unsigned_t>::usedcount(buffer[i])]++;
+
+		size_t best_space = 0, count = 0;
+		chunk_nbits = nbits;
+		for (size_t b = nbits; b > 0; b--) {
+			const size_t space = 2 + count + xspace(count, nbits - b)
+					     + bitpck_codec<unsigned_t>::space(m, b);
+			if (b == nbits || space < best_space) {
+				best_space = space;
+				chunk_nbits = b;
+			}
+			count += histogram[b];
+		}
+		return best_space;
+	}
+
+	// Unpack a chunk and patch its exceptions.
+	static void
+	chunk_decode(unsigned_t *buffer, const size_t m, src_bytes_t &src, const size_t nbits)
+	{
+		const size_t chunk_nbits = src[0];
+		const size_t count = src[1];
+		const src_bytes_t positions = src + 2;
+		const src_bytes_t xbits = positions + count;
+		const size_t xnbits = nbits - chunk_nbits;
+		src = xbits + xspace(count, xnbits);
+
+		bitpck_codec<unsigned_t>::decode(buffer, buffer + m, src, chunk_nbits);
+		for (size_t j = 0; j < count; j++) {
+			const uint64_t x = get_bits(xbits, j * xnbits, xnbits);
+			buffer[positions[j]] |= unsigned_t(x) << chunk_nbits;
+		}
+	}
+
+	// Skip over a number of full chunks.
+	static src_bytes_t seek(src_bytes_t src, size_t nchunks, const size_t nbits)
+	{
+		for (; nchunks; nchunks--) {
+			const size_t chunk_nbits = src[0];
+			const size_t count = src[1];
+			src += 2 + count + xspace(count, nbits - chunk_nbits)
+			       + bitpck_codec<unsigned_t>::space(chunk_capacity, chunk_nbits);
+		}
+		return src;
+	}
+
+	// Store a value with a given number of bits at a given bit offset of
+	// a zeroed byte stream.
+	static void put_bits(dst_bytes_t dst, size_t offset, uint64_t value, size_t n)
+	{
+		if (n < 64)
+			value &= (uint64_t(1) << n) - 1;
+		dst += offset / 8;
+		size_t shift = offset % 8;
+		for (; n; dst++) {
+			*dst |= byte_t(value << shift);
+			const size_t k = std::min(n, 8 - shift);
+			value >>= k;
+			n -= k;
+			shift = 0;
+		}
+	}
+
+	// Load a value with a given number of bits from a given bit offset of
+	// a byte stream.
+	static uint64_t get_bits(src_bytes_t src, size_t offset, const size_t n)
+	{
+		src += offset / 8;
+		const size_t shift = offset % 8;
+		const size_t nbytes = (shift + n + 7) / 8;
+
+		uint64_t value = 0;
+		for (size_t k = 0; k < nbytes && k < 8; k++)
+			value |= uint64_t(src[k]) << (k * 8);
+		value >>= shift;
+		// The value spans 9 bytes.
+		if (nbytes > 8)
+			value |= uint64_t(src[8]) << (64 - shift);
+
+		const uint64_t mask = n < 64 ? (uint64_t(1) << n) - 1 : uint64_t(int64_t(-1));
+		return value & mask;
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_OPTPFD_H_ */
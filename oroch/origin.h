@@ -53,6 +53,23 @@ public:
 		return original_t(v + origin_);
 	}
 
+	// Translate a range of values [lo, hi] to the encoded form. The part
+	// of the range below the origin is cut off. A range that lies entirely
+	// below the origin becomes empty, that is lo > hi.
+	void range_encode(unsigned_t &elo,
+			  unsigned_t &ehi,
+			  const original_t lo,
+			  const original_t hi) const
+	{
+		if (hi < lo || hi < origin_) {
+			elo = 1;
+			ehi = 0;
+		} else {
+			elo = lo < origin_ ? 0 : value_encode(lo);
+			ehi = value_encode(hi);
+		}
+	}
+
 private:
 	const original_t origin_;
 };
@@ -0,0 +1,429 @@
+// pagpfr.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_PAGPFR_H_
+#define OROCH_PAGPFR_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include "bitpck.h"
+#include "common.h"
+#include "integer_traits.h"
+#include "varint.h"
+#include "zigzag.h"
+
+namespace oroch {
+
+//
+// Patched bit-packing of a page made of many groups with the exceptions of
+// all the groups pooled together after the FastPFOR scheme described in
+// "Decoding billions of integers per second through vectorization" by
+// Daniel Lemire and Leonid Boytsov.
+//
+// Integers are split into groups of 128. Every group has its own bit width
+// chosen to minimize its size. The integers that do not fit the width are
+// exceptions. Their low bits are packed along with the regular integers.
+// Their high bits take up to a given maximum width less the group width.
+// They go to a page-wide bucket for this number of bits. So a group only
+// needs a few bytes to describe its exceptions:
+//
+//   * the bit width,
+//   * the number of exceptions,
+//   * the exception positions within the group, a byte each,
+//   * the low bits of all the integers packed as with bitpck_codec.
+//
+// The page starts with the bucket table. It has the number of buckets and
+// for every one of them its number of bits and the number of exceptions in
+// it. Then go the buckets themselves one after another in a single stream
+// of 64-bit words like with bitstr_codec and then all the groups. Unlike
+// optpfd_codec the high bits are not rounded up to a byte for every group.
+//
+// A group where every integer is zero takes just two bytes. Random access
+// skips over the preceding groups one by one using their headers and counts
+// the exceptions they take from every bucket.
+//
+// By default the codec applies zigzag encoding if used on signed types.
+// This can be replaced by supplying a different value code explicitly.
+//
+template <typename T, typename V = zigzag_codec<T>>
+class pagpfr_codec
+{
+public:
+	using original_t = T;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+	using value_codec = V;
+
+	static constexpr size_t group_capacity = 128;
+
+	// Get the number of bytes required to encode a given integer sequence.
+	template <typename Iter>
+	static size_t
+	space(Iter src, Iter const end, const size_t nbits, value_codec vcodec = value_codec())
+	{
+		size_t counts[nbits_max + 1] = {};
+		size_t size = 0;
+		while (src != end) {
+			unsigned_t buffer[group_capacity];
+			const size_t m = group_fill(buffer, src, end, vcodec);
+			const layout group = group_layout(buffer, m, nbits);
+			counts[nbits - group.nbits] += group.count;
+			size += group_space(group, m);
+		}
+		return size + table_space(counts);
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst,
+			   Iter src,
+			   Iter const end,
+			   const size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		// Count the exceptions that go to every bucket.
+		size_t counts[nbits_max + 1] = {};
+		for (Iter cur = src; cur != end;) {
+			unsigned_t buffer[group_capacity];
+			const size_t m = group_fill(buffer, cur, end, vcodec);
+			const layout group = group_layout(buffer, m, nbits);
+			counts[nbits - group.nbits] += group.count;
+		}
+
+		// Store the bucket table and find the bit offset of every
+		// bucket.
+		size_t nbuckets = 0;
+		for (size_t x = 1; x <= nbits_max; x++)
+			nbuckets += counts[x] != 0;
+		*dst++ = byte_t(nbuckets);
+		size_t offsets[nbits_max + 1] = {};
+		size_t stream_nbits = 0;
+		for (size_t x = 1; x <= nbits_max; x++) {
+			if (counts[x] == 0)
+				continue;
+			*dst++ = byte_t(x);
+			varint_codec<size_t>::value_encode(dst, counts[x]);
+			offsets[x] = stream_nbits;
+			stream_nbits += counts[x] * x;
+		}
+
+		// Reserve zeroed space for the buckets.
+		const dst_bytes_t stream = dst;
+		std::memset(stream, 0, stream_space(stream_nbits));
+		dst += stream_space(stream_nbits);
+
+		// Store the groups and put the exceptions to the buckets.
+		while (src != end) {
+			unsigned_t buffer[group_capacity];
+			const size_t m = group_fill(buffer, src, end, vcodec);
+			const layout group = group_layout(buffer, m, nbits);
+
+			*dst++ = byte_t(group.nbits);
+			*dst++ = byte_t(group.count);
+			if (group.count) {
+				const size_t x = nbits - group.nbits;
+				for (size_t i = 0; i < m; i++) {
+					const uint64_t high = buffer[i] >> group.nbits;
+					if (high == 0)
+						continue;
+					*dst++ = byte_t(i);
+					deposit(stream, offsets[x], high, x);
+					offsets[x] += x;
+				}
+			}
+			if (group.nbits)
+				bitpck_codec<unsigned_t>::encode(
+					dst, buffer, buffer + m, group.nbits);
+		}
+	}
+
+	template <typename Iter>
+	static void decode(Iter dst,
+			   Iter const end,
+			   src_bytes_t &src,
+			   const size_t nbits,
+			   value_codec vcodec = value_codec())
+	{
+		bucket_table table;
+		src = table_decode(table, src);
+		groups_decode(dst, end, src, table, nbits, vcodec);
+	}
+
+	static original_t fetch(src_bytes_t src,
+				const size_t index,
+				const size_t nbits,
+				value_codec vcodec = value_codec())
+	{
+		bucket_table table;
+		src = table_decode(table, src);
+		src = seek(src, index / group_capacity, table, nbits);
+
+		const size_t group_nbits = src[0];
+		const size_t count = src[1];
+		const src_bytes_t positions = src + 2;
+		const size_t x = nbits - group_nbits;
+		const size_t i = index % group_capacity;
+
+		const src_bytes_t bits = positions + count;
+		unsigned_t value = 0;
+		if (group_nbits)
+			value = bitpck_codec<unsigned_t>::fetch(bits, i, group_nbits);
+		const void *position = std::memchr(positions, int(i), count);
+		if (position != nullptr) {
+			const size_t j = static_cast<src_bytes_t>(position) - positions;
+			const size_t offset = table.offsets[x] + j * x;
+			value |= unsigned_t(extract(table.stream, offset, x)) << group_nbits;
+		}
+		return vcodec.value_decode(value);
+	}
+
+	// Decode integers starting from a given position. The decoding starts
+	// right at the group that contains the first requested integer.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const size_t nbits,
+				 value_codec vcodec = value_codec())
+	{
+		bucket_table table;
+		src = table_decode(table, src);
+		src = seek(src, first / group_capacity, table, nbits);
+
+		// Take the integers from a partially requested group.
+		size_t index = first % group_capacity;
+		if (index && dst != end) {
+			unsigned_t buffer[group_capacity];
+			const size_t m = std::min(size_t(std::distance(dst, end)) + index,
+						  group_capacity);
+			group_decode(buffer, m, src, table, nbits);
+			for (; index < m; index++)
+				*dst++ = vcodec.value_decode(buffer[index]);
+		}
+
+		groups_decode(dst, end, src, table, nbits, vcodec);
+	}
+
+private:
+	static constexpr size_t nbits_max = integer_traits<unsigned_t>::nbits;
+
+	// The chosen encoding of a group.
+	struct layout
+	{
+		size_t nbits;
+		size_t count;
+	};
+
+	// The location of the bucket stream and the bit offset of the next
+	// exception in every bucket.
+	struct bucket_table
+	{
+		src_bytes_t stream = nullptr;
+		size_t offsets[nbits_max + 1] = {};
+	};
+
+	template <typename Iter>
+	static size_t
+	group_fill(unsigned_t *buffer, Iter &src, Iter const end, value_codec &vcodec)
+	{
+		size_t m = 0;
+		for (; m < group_capacity && src != end; m++)
+			buffer[m] = vcodec.value_encode(*src++);
+		return m;
+	}
+
+	// Get the number of bytes required for a group itself. The exception
+	// high bits are accounted separately.
+	static size_t group_space(const layout &group, const size_t m)
+	{
+		size_t size = 2 + group.count;
+		if (group.nbits)
+			size += bitpck_codec<unsigned_t>::space(m, group.nbits);
+		return size;
+	}
+
+	// Choose the bit width for a group. For every width the number of
+	// exceptions is found with a histogram of the integer widths. The
+	// cost of a choice is counted in bits including the exception high
+	// bits in the bucket. The widest of the best choices is taken as it
+	// has fewer exceptions to patch. A group of zeros has no width.
+	static layout group_layout(const unsigned_t *buffer, const size_t m, const size_t nbits)
+	{
+		size_t histogram[nbits_max + 1] = {};
+		for (size_t i = 0; i < m; i++)
+			histogram[integer_traits<unsigned_t>::usedcount(buffer[i])]++;
+
+		layout best = {nbits, 0};
+		size_t best_cost = 8 * group_space(best, m);
+		size_t count = 0;
+		for (size_t b = nbits; b-- > 0;) {
+			count += histogram[b + 1];
+			const layout group = {b, count};
+			const size_t cost = 8 * group_space(group, m) + count * (nbits - b);
+			if (cost < best_cost) {
+				best_cost = cost;
+				best = group;
+			}
+		}
+		return best;
+	}
+
+	// Get the number of bytes required for a stream of 64-bit words.
+	static constexpr size_t stream_space(size_t nbits)
+	{
+		return sizeof(uint64_t) * ((nbits + 63) / 64);
+	}
+
+	// Get the number of bytes required for the bucket table and all the
+	// buckets.
+	static size_t table_space(const size_t *counts)
+	{
+		size_t size = 1;
+		size_t stream_nbits = 0;
+		for (size_t x = 1; x <= nbits_max; x++) {
+			if (counts[x] == 0)
+				continue;
+			size += 1 + varint_codec<size_t>::value_space(counts[x]);
+			stream_nbits += counts[x] * x;
+		}
+		return size + stream_space(stream_nbits);
+	}
+
+	// Read the bucket table and find the start of every bucket. Returns
+	// the start of the first group.
+	static src_bytes_t table_decode(bucket_table &table, src_bytes_t src)
+	{
+		size_t nbuckets = *src++;
+		size_t stream_nbits = 0;
+		for (size_t k = 0; k < nbuckets; k++) {
+			const size_t x = *src++;
+			table.offsets[x] = stream_nbits;
+			stream_nbits += varint_codec<size_t>::value_decode(src) * x;
+		}
+		table.stream = src;
+		return src + stream_space(stream_nbits);
+	}
+
+	// Unpack a group and patch its exceptions.
+	static void group_decode(unsigned_t *buffer,
+				 const size_t m,
+				 src_bytes_t &src,
+				 bucket_table &table,
+				 const size_t nbits)
+	{
+		const size_t group_nbits = src[0];
+		const size_t count = src[1];
+		const src_bytes_t positions = src + 2;
+		src = positions + count;
+
+		if (group_nbits)
+			bitpck_codec<unsigned_t>::decode(buffer, buffer + m, src, group_nbits);
+		else
+			std::fill_n(buffer, m, unsigned_t(0));
+
+		const size_t x = nbits - group_nbits;
+		size_t offset = table.offsets[x];
+		for (size_t j = 0; j < count; j++, offset += x) {
+			const uint64_t high = extract(table.stream, offset, x);
+			buffer[positions[j]] |= unsigned_t(high) << group_nbits;
+		}
+		table.offsets[x] = offset;
+	}
+
+	template <typename Iter>
+	static void groups_decode(Iter dst,
+				  Iter const end,
+				  src_bytes_t &src,
+				  bucket_table &table,
+				  const size_t nbits,
+				  value_codec &vcodec)
+	{
+		for (auto n = std::distance(dst, end); n > 0; n -= group_capacity) {
+			const size_t m = std::min(size_t(n), group_capacity);
+			unsigned_t buffer[group_capacity];
+			group_decode(buffer, m, src, table, nbits);
+			for (size_t i = 0; i < m; i++)
+				*dst++ = vcodec.value_decode(buffer[i]);
+		}
+	}
+
+	// Skip over a number of full groups and account their exceptions.
+	static src_bytes_t
+	seek(src_bytes_t src, size_t ngroups, bucket_table &table, const size_t nbits)
+	{
+		for (; ngroups; ngroups--) {
+			const size_t group_nbits = src[0];
+			const size_t count = src[1];
+			const size_t x = nbits - group_nbits;
+			table.offsets[x] += count * x;
+			src += group_space({group_nbits, count}, group_capacity);
+		}
+		return src;
+	}
+
+	// The bucket stream follows the variable-length bucket table so its
+	// words might be unaligned.
+	static uint64_t load(src_bytes_t src, const size_t index)
+	{
+		uint64_t word;
+		std::memcpy(&word, src + index * sizeof(uint64_t), sizeof word);
+		return word;
+	}
+
+	static void store(dst_bytes_t dst, const size_t index, const uint64_t word)
+	{
+		std::memcpy(dst + index * sizeof(uint64_t), &word, sizeof word);
+	}
+
+	// Put the high bits of an exception to the bucket stream at a given
+	// bit offset.
+	static void
+	deposit(dst_bytes_t dst, const size_t offset, const uint64_t value, const size_t nbits)
+	{
+		const size_t index = offset / 64;
+		const size_t shift = offset % 64;
+		store(dst, index, load(dst, index) | (value << shift));
+		if (shift + nbits > 64)
+			store(dst, index + 1, load(dst, index + 1) | (value >> (64 - shift)));
+	}
+
+	// Get the high bits of an exception from the bucket stream at a given
+	// bit offset.
+	static uint64_t extract(src_bytes_t src, const size_t offset, const size_t nbits)
+	{
+		const size_t index = offset / 64;
+		const size_t shift = offset % 64;
+		const uint64_t mask = uint64_t(int64_t(-1)) >> (64 - nbits);
+
+		uint64_t x = load(src, index) >> shift;
+		if (shift + nbits > 64)
+			x |= load(src, index + 1) << (64 - shift);
+		return x & mask;
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_PAGPFR_H_ */
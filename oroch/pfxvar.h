@@ -0,0 +1,183 @@
+// pfxvar.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_PFXVAR_H_
+#define OROCH_PFXVAR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include "common.h"
+#include "integer_traits.h"
+#include "zigzag.h"
+
+namespace oroch {
+
+//
+// Prefix variable byte encoding of integers. Like with the varint encoding
+// every byte of the encoded data carries a 7-bit group from the original
+// integer. But instead of a continuation bit in every byte the total length
+// is given by the number of trailing zero bits in the first byte. Thus the
+// length of an integer is known right after the first byte is read.
+//
+// An integer that does not fit into 8 bytes of this encoding (that is it has
+// more than 56 significant bits) takes a zero first byte followed by 8 bytes
+// of the integer itself.
+//
+// The codec automatically applies zigzag encoding if used on signed types.
+//
+template <typename T, typename V = zigzag_codec<T>>
+class pfxvar_codec
+{
+public:
+	using original_t = T;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+	using value_codec = V;
+
+	// The number of bytes needed to encode an integer with the given
+	// number of significant bits.
+	static constexpr size_t nbits_space(size_t nbits)
+	{
+		return nbits <= 7 ? 1 : nbits <= 56 ? (nbits + 6) / 7 : 9;
+	}
+
+	// The maximum number of bytes needed to encode an integer of the
+	// template-specified type.
+	static constexpr size_t nbytemax = nbits_space(integer_traits<original_t>::nbits);
+
+	// Get the number of bytes needed to encode a given integer value.
+	static size_t value_space(original_t src, value_codec vcodec = value_codec())
+	{
+		unsigned_t value = vcodec.value_encode(src);
+		return nbits_space(integer_traits<unsigned_t>::usedcount(value));
+	}
+
+	static void
+	value_encode(dst_bytes_t &dst, original_t src, value_codec vcodec = value_codec())
+	{
+		uint64_t value = vcodec.value_encode(src);
+		size_t length = nbits_space(integer_traits<uint64_t>::usedcount(value));
+		if (length > 8) {
+			*dst++ = 0;
+			length = 8;
+		} else {
+			value = (value << length) | (uint64_t(1) << (length - 1));
+		}
+		for (size_t i = 0; i < length; i++) {
+			*dst++ = byte_t(value);
+			value >>= 8;
+		}
+	}
+
+	static original_t value_decode(src_bytes_t &src, value_codec vcodec = value_codec())
+	{
+		const byte_t first = *src;
+		if (first == 0) {
+			uint64_t value = 0;
+			for (size_t i = 0; i < 8; i++)
+				value |= uint64_t(src[i + 1]) << (i * 8);
+			src += 9;
+			return vcodec.value_decode(unsigned_t(value));
+		}
+
+		const size_t length = integer_traits<unsigned>::ctz(first) + 1;
+		uint64_t value = 0;
+		for (size_t i = 0; i < length; i++)
+			value |= uint64_t(src[i]) << (i * 8);
+		src += length;
+		return vcodec.value_decode(unsigned_t(value >> length));
+	}
+
+	static void
+	value_decode(original_t &dst, src_bytes_t &src, value_codec vcodec = value_codec())
+	{
+		dst = value_decode(src, vcodec);
+	}
+
+	// Decode an integer with a single 8-byte load. It might read past
+	// the end of the encoded integer so the caller must ensure that 8
+	// bytes (or 9 bytes for a zero first byte) are readable.
+	static original_t
+	unsafe_value_decode(src_bytes_t &src, value_codec vcodec = value_codec())
+	{
+		uint64_t word;
+		std::memcpy(&word, src, sizeof word);
+
+		const size_t length = integer_traits<uint64_t>::ctz(word | 0x100) + 1;
+		if (length > 8) {
+			std::memcpy(&word, src + 1, sizeof word);
+			src += 9;
+			return vcodec.value_decode(unsigned_t(word));
+		}
+
+		src += length;
+		word = (word << (64 - length * 8)) >> (64 - length * 7);
+		return vcodec.value_decode(unsigned_t(word));
+	}
+
+	// Get the number of bytes needed to encode a given integer sequence.
+	template <typename Iter>
+	static size_t space(Iter src, Iter const end, value_codec vcodec = value_codec())
+	{
+		size_t count = 0;
+		while (src != end)
+			count += value_space(*src++, vcodec);
+		return count;
+	}
+
+	template <typename Iter>
+	static void
+	encode(dst_bytes_t &dst, Iter src, Iter const end, value_codec vcodec = value_codec())
+	{
+		while (src != end)
+			value_encode(dst, *src++, vcodec);
+	}
+
+	// Skip over a given number of encoded integers.
+	static void skip(src_bytes_t &src, size_t nvalues)
+	{
+		while (nvalues--) {
+			const byte_t first = *src;
+			src += first ? integer_traits<unsigned>::ctz(first) + 1 : 9;
+		}
+	}
+
+	template <typename Iter>
+	static void
+	decode(Iter dst, Iter const end, src_bytes_t &src, value_codec vcodec = value_codec())
+	{
+		// Every integer takes at least one byte so while there are
+		// at least 8 integers left it is safe to load 8 bytes. And if
+		// the first byte is zero then there are at least 16 bytes.
+		for (auto n = std::distance(dst, end); n >= 8; n--)
+			*dst++ = unsafe_value_decode(src, vcodec);
+		while (dst != end)
+			value_decode(*dst++, src, vcodec);
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_PFXVAR_H_ */
@@ -0,0 +1,185 @@
+// runlen.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_RUNLEN_H_
+#define OROCH_RUNLEN_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "common.h"
+
+namespace oroch {
+
+//
+// Run-length encoding. A sequence is split into runs of equal integers.
+// Every run is represented with its value and its end position, that is
+// the position right after its last integer. The end positions grow so
+// they might be looked up with a binary search.
+//
+// This codec only deals with the runs themselves. The run values and the
+// end positions are two separate integer sequences that are supposed to be
+// encoded with some other codecs. This is done by integer_codec.
+//
+// Many operations work on the runs directly without expanding them.
+//
+template <typename T>
+class runlen_codec
+{
+public:
+	using original_t = T;
+
+	struct runs
+	{
+		std::vector<original_t> values;
+		std::vector<size_t> ends;
+
+		size_t size() const
+		{
+			return values.size();
+		}
+
+		// Get the start position of a run.
+		size_t start(size_t run) const
+		{
+			return run ? ends[run - 1] : 0;
+		}
+
+		void clear()
+		{
+			values.clear();
+			ends.clear();
+		}
+
+		// Prepare for decoding of a sequence with a given number of
+		// runs.
+		void resize(size_t nruns)
+		{
+			values.resize(nruns);
+			ends.resize(nruns);
+		}
+	};
+
+	// Split a sequence into runs.
+	template <typename Iter>
+	static void split(runs &r, Iter src, Iter const end)
+	{
+		r.clear();
+		for (size_t position = 0; src != end; ++src, ++position) {
+			if (r.size() && r.values.back() == *src) {
+				r.ends.back()++;
+			} else {
+				r.values.push_back(*src);
+				r.ends.push_back(position + 1);
+			}
+		}
+	}
+
+	// Expand runs starting from a given position. Every run is filled with
+	// a single call so the compiler turns it into wide stores.
+	template <typename Iter>
+	static void fill(Iter dst, Iter const end, const runs &r, size_t first = 0)
+	{
+		size_t run = std::upper_bound(r.ends.begin(), r.ends.end(), first)
+			     - r.ends.begin();
+		for (size_t position = first; dst != end; run++) {
+			const size_t n = std::min(r.ends[run] - position,
+						  size_t(std::distance(dst, end)));
+			dst = std::fill_n(dst, n, r.values[run]);
+			position += n;
+		}
+	}
+
+	// Find the position of the first integer equal to a given one. If
+	// there is no such integer then the total number of integers is
+	// returned.
+	static size_t find(const runs &r, const original_t value)
+	{
+		const auto it = std::find(r.values.begin(), r.values.end(), value);
+		if (it == r.values.end())
+			return r.size() ? r.ends.back() : 0;
+		return r.start(it - r.values.begin());
+	}
+
+	// Sum up the integers using a given type for the sum.
+	template <typename S>
+	static S sum(const runs &r)
+	{
+		S s = 0;
+		for (size_t run = 0; run < r.size(); run++)
+			s += S(r.values[run]) * S(r.ends[run] - r.start(run));
+		return s;
+	}
+
+	// Count the integers within the range [lo, hi].
+	static size_t count(const runs &r, const original_t lo, const original_t hi)
+	{
+		size_t n = 0;
+		for (size_t run = 0; run < r.size(); run++) {
+			if (lo <= r.values[run] && r.values[run] <= hi)
+				n += r.ends[run] - r.start(run);
+		}
+		return n;
+	}
+
+	// Find the integers within the range [lo, hi] and mark them in a bitmap
+	// with a bit per integer. Returns the number of found integers.
+	static size_t scan(uint64_t *bitmap,
+			   const runs &r,
+			   const size_t nvalues,
+			   const original_t lo,
+			   const original_t hi)
+	{
+		std::fill_n(bitmap, (nvalues + 63) / 64, uint64_t(0));
+
+		size_t n = 0;
+		for (size_t run = 0; run < r.size(); run++) {
+			if (r.values[run] < lo || hi < r.values[run])
+				continue;
+			const size_t start = r.start(run);
+			n += r.ends[run] - start;
+			mark(bitmap, start, r.ends[run]);
+		}
+		return n;
+	}
+
+private:
+	// Set the bits from a start position to an end position (exclusive).
+	static void mark(uint64_t *bitmap, size_t start, const size_t end)
+	{
+		while (start < end) {
+			const size_t shift = start % 64;
+			const size_t n = std::min(end - start, 64 - shift);
+			const uint64_t bits = n < 64 ? (uint64_t(1) << n) - 1
+						     : uint64_t(int64_t(-1));
+			bitmap[start / 64] |= bits << shift;
+			start += n;
+		}
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_RUNLEN_H_ */
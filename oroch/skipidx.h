@@ -0,0 +1,138 @@
+// skipidx.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_SKIPIDX_H_
+#define OROCH_SKIPIDX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include "common.h"
+
+namespace oroch {
+
+//
+// A sampled skip index for byte-aligned variable length encodings, that is
+// varint and pfxvar. The index is a table of 32-bit byte offsets placed in
+// front of the encoded data. It samples every stride-th integer starting
+// from the first one. The offsets are relative to the table start so the
+// first offset is also the table size.
+//
+// With the index an arbitrary integer is reached by a table lookup and then
+// skipping less than stride integers.
+//
+template <typename C>
+class skipidx_codec
+{
+public:
+	using basic_codec = C;
+	using original_t = typename basic_codec::original_t;
+	using value_codec = typename basic_codec::value_codec;
+
+	// Get the number of bytes needed for the index.
+	static constexpr size_t index_space(size_t nvalues, size_t stride)
+	{
+		return ((nvalues + stride - 1) / stride) * sizeof(uint32_t);
+	}
+
+	// Get the number of bytes needed to encode a given integer sequence
+	// along with the index.
+	template <typename Iter>
+	static size_t
+	space(Iter src, Iter const end, size_t stride, value_codec vcodec = value_codec())
+	{
+		return index_space(std::distance(src, end), stride)
+			+ basic_codec::space(src, end, vcodec);
+	}
+
+	template <typename Iter>
+	static void encode(dst_bytes_t &dst,
+			   Iter src,
+			   Iter const end,
+			   size_t stride,
+			   value_codec vcodec = value_codec())
+	{
+		const size_t nvalues = std::distance(src, end);
+		uint32_t offset = index_space(nvalues, stride);
+		Iter cur = src;
+		for (size_t i = 0; i < nvalues; i++) {
+			if ((i % stride) == 0) {
+				std::memcpy(dst, &offset, sizeof offset);
+				dst += sizeof offset;
+			}
+			offset += basic_codec::value_space(*cur++, vcodec);
+		}
+
+		basic_codec::encode(dst, src, end, vcodec);
+	}
+
+	template <typename Iter>
+	static void
+	decode(Iter dst, Iter const end, src_bytes_t &src, value_codec vcodec = value_codec())
+	{
+		if (dst == end)
+			return;
+		src = lookup(src, 0);
+		basic_codec::decode(dst, end, src, vcodec);
+	}
+
+	// Get an integer at a given position.
+	static original_t fetch(src_bytes_t src,
+				const size_t index,
+				const size_t stride,
+				value_codec vcodec = value_codec())
+	{
+		src = lookup(src, index / stride);
+		basic_codec::skip(src, index % stride);
+		return basic_codec::value_decode(src, vcodec);
+	}
+
+	// Decode integers starting from a given position.
+	template <typename Iter>
+	static void decode_range(Iter dst,
+				 Iter const end,
+				 src_bytes_t src,
+				 const size_t first,
+				 const size_t stride,
+				 value_codec vcodec = value_codec())
+	{
+		src = lookup(src, first / stride);
+		basic_codec::skip(src, first % stride);
+		basic_codec::decode(dst, end, src, vcodec);
+	}
+
+private:
+	// Get the encoded data position for a given index sample.
+	static src_bytes_t lookup(src_bytes_t src, size_t sample)
+	{
+		uint32_t offset;
+		std::memcpy(&offset, src + sample * sizeof offset, sizeof offset);
+		return src + offset;
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_SKIPIDX_H_ */
@@ -0,0 +1,233 @@
+// svbyte.h
+//
+// Copyright (c) 2016  Aleksey Demakov
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef OROCH_SVBYTE_H_
+#define OROCH_SVBYTE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+#include "common.h"
+#include "integer_traits.h"
+#include "zigzag.h"
+
+namespace oroch {
+
+namespace detail {
+
+#if defined(__SSSE3__)
+
+//
+// Shuffle table for the Stream VByte decoder. An entry is selected by
+// a control byte. Its shuffle mask moves 4 integers of 1 to 4 bytes into
+// separate 32-bit lanes.
+//
+struct svbyte_shuffle
+{
+	byte_t shuffle[16];
+	// The number of input bytes consumed.
+	byte_t nbytes;
+};
+
+struct svbyte_shuffle_table
+{
+	svbyte_shuffle entries[256];
+
+	constexpr svbyte_shuffle_table() : entries{}
+	{
+		for (unsigned control = 0; control < 256; control++) {
+			svbyte_shuffle &entry = entries[control];
+
+			unsigned pos = 0;
+			for (unsigned lane = 0; lane < 4; lane++) {
+				unsigned length = ((control >> (lane * 2)) & 3) + 1;
+				for (unsigned i = 0; i < 4; i++)
+					entry.shuffle[lane * 4 + i]
+						= i < length ? pos + i : 0x80;
+				pos += length;
+			}
+			entry.nbytes = pos;
+		}
+	}
+};
+
+inline constexpr svbyte_shuffle_table svbyte_shuffle_masks;
+
+#endif
+
+} // namespace oroch::detail
+
+//
+// Stream VByte encoding of integers as described here:
+//
+// https://arxiv.org/abs/1709.08990
+//
+// Every integer is stored with a whole number of bytes. The byte length is
+// given by a 2-bit code. The codes are kept in a separate control stream in
+// front of the data stream. This way it is possible to decode several data
+// integers at once with a shuffle table indexed by a control byte.
+//
+// For 64-bit integers the codes stand for 1, 2, 4, and 8 bytes. For shorter
+// integers they stand for 1, 2, 3, and 4 bytes.
+//
+// The codec automatically applies zigzag encoding if used on signed types.
+//
+template <typename T, typename V = zigzag_codec<T>>
+class svbyte_codec
+{
+public:
+	using original_t = T;
+	using unsigned_t = typename integer_traits<original_t>::unsigned_t;
+	using value_codec = V;
+
+	static constexpr size_t nbytes = integer_traits<original_t>::nbytes;
+
+	// Get the number of data bytes for a given length code.
+	static constexpr size_t code_length(unsigned code)
+	{
+		return nbytes > 4 ? size_t(1) << code : code + 1;
+	}
+
+	// Get the length code for a value with a given number of bits.
+	static constexpr unsigned nbits_code(size_t nbits)
+	{
+		const size_t length = (nbits + 7) / 8;
+		if (nbytes > 4)
+			return length > 4 ? 3 : length > 2 ? 2 : length > 1 ? 1 : 0;
+		return length > 1 ? length - 1 : 0;
+	}
+
+	// Get the number of data bytes for a value with a given number of bits.
+	static constexpr size_t nbits_space(size_t nbits)
+	{
+		return code_length(nbits_code(nbits));
+	}
+
+	// Get the length code for a given encoded value.
+	static unsigned value_code(unsigned_t value)
+	{
+		return nbits_code(integer_traits<unsigned_t>::usedcount(value));
+	}
+
+	// Get the number of control bytes needed for a given number of
+	// integers.
+	static constexpr size_t control_space(size_t nvalues)
+	{
+		return (nvalues + 3) / 4;
+	}
+
+	// Get the number of data bytes needed to encode a given integer value.
+	static size_t value_space(original_t src, value_codec vcodec = value_codec())
+	{
+		return code_length(value_code(vcodec.value_encode(src)));
+	}
+
+	// Get the number of bytes needed to encode a given integer sequence.
+	template <typename Iter>
+	static size_t space(Iter src, Iter const end, value_codec vcodec = value_codec())
+	{
+		size_t nvalues = 0, count = 0;
+		for (; src != end; nvalues++)
+			count += value_space(*src++, vcodec);
+		return control_space(nvalues) + count;
+	}
+
+	template <typename Iter>
+	static void
+	encode(dst_bytes_t &dst, Iter src, Iter const end, value_codec vcodec = value_codec())
+	{
+		const size_t nvalues = std::distance(src, end);
+		dst_bytes_t control = dst;
+		dst += control_space(nvalues);
+
+		for (size_t i = 0; i < nvalues; i++) {
+			unsigned_t value = vcodec.value_encode(*src++);
+			unsigned code = value_code(value);
+
+			const size_t shift = (i % 4) * 2;
+			if (shift == 0)
+				control[i / 4] = code;
+			else
+				control[i / 4] |= code << shift;
+
+			const size_t length = code_length(code);
+			for (size_t k = 0; k < length; k++) {
+				*dst++ = byte_t(value);
+				value >>= 8;
+			}
+		}
+	}
+
+	template <typename Iter>
+	static void
+	decode(Iter dst, Iter const end, src_bytes_t &src, value_codec vcodec = value_codec())
+	{
+		const size_t nvalues = std::distance(dst, end);
+		src_bytes_t control = src;
+		src += control_space(nvalues);
+
+		size_t i = 0;
+#if defined(__SSSE3__)
+		// Every integer takes at least one byte so while there are
+		// at least 16 integers left it is safe to load 16 bytes.
+		if (nbytes <= 4) {
+			for (; i + 16 <= nvalues; i += 4) {
+				const detail::svbyte_shuffle &entry
+					= detail::svbyte_shuffle_masks.entries[control[i / 4]];
+
+				const __m128i v = _mm_shuffle_epi8(
+					_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)),
+					_mm_loadu_si128(reinterpret_cast<const __m128i *>(
+						entry.shuffle)));
+
+				alignas(16) uint32_t values[4];
+				_mm_store_si128(reinterpret_cast<__m128i *>(values), v);
+				for (size_t k = 0; k < 4; k++)
+					*dst++ = vcodec.value_decode(unsigned_t(values[k]));
+
+				src += entry.nbytes;
+			}
+		}
+#endif
+		for (; i < nvalues; i++) {
+			const unsigned code = (control[i / 4] >> ((i % 4) * 2)) & 3;
+			const size_t length = code_length(code);
+
+			unsigned_t value = 0;
+			for (size_t k = 0; k < length; k++)
+				value |= unsigned_t(src[k]) << (k * 8);
+			src += length;
+
+			*dst++ = vcodec.value_decode(value);
+		}
+	}
+};
+
+} // namespace oroch
+
+#endif /* OROCH_SVBYTE_H_ */
@@ -25,6 +25,12 @@
 #define OROCH_VARINT_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
 
 #include "common.h"
 #include "integer_traits.h"
@@ -32,6 +38,66 @@
 
 namespace oroch {
 
+namespace detail {
+
+#if defined(__SSSE3__)
+
+//
+// Shuffle table for the Masked VByte decoder described here:
+//
+// https://arxiv.org/abs/1503.07387
+//
+// An entry is selected by the continuation bits of the next 12 input bytes.
+// Its shuffle mask moves up to 4 complete integers into separate 32-bit lanes
+// provided that none of them is longer than 4 bytes.
+//
+struct varint_shuffle
+{
+	byte_t shuffle[16];
+	// The number of input bytes consumed.
+	byte_t nbytes;
+	// The number of integers decoded.
+	byte_t nvalues;
+};
+
+struct varint_shuffle_table
+{
+	static constexpr unsigned nmaskbits = 12;
+	static constexpr unsigned nmasks = 1u << nmaskbits;
+
+	varint_shuffle entries[nmasks];
+
+	constexpr varint_shuffle_table() : entries{}
+	{
+		for (unsigned mask = 0; mask < nmasks; mask++) {
+			varint_shuffle &entry = entries[mask];
+			for (unsigned i = 0; i < 16; i++)
+				entry.shuffle[i] = 0x80;
+
+			unsigned pos = 0;
+			while (entry.nvalues < 4) {
+				unsigned end = pos;
+				while (end < nmaskbits && (mask & (1u << end)) != 0)
+					end++;
+				if (end == nmaskbits || end - pos >= 4)
+					break;
+
+				for (unsigned i = pos; i <= end; i++)
+					entry.shuffle[entry.nvalues * 4 + i - pos] = i;
+				entry.nvalues++;
+				pos = end + 1;
+			}
+			entry.nbytes = pos;
+		}
+	}
+};
+
+inline constexpr varint_shuffle_table varint_shuffle_masks;
+
+#endif
+
+} // namespace oroch::detail
+
 //
 // Variable byte encoding of integers. Every byte of the encoded data
 // represents a 7-bit group from the original integer. The 8th bit is used as
@@ -43,6 +109,9 @@ namespace oroch {
 //
 // The codec automatically applies zigzag encoding if used on signed types.
 //
+// If SSSE3 instructions are available then the bulk decoder uses shuffle
+// tables to decode a few short integers at once.
+//
 template <typename T, typename V = zigzag_codec<T>>
 class varint_codec
 {
@@ -138,13 +207,102 @@ public:
 			value_encode(dst, *src++, vcodec);
 	}
 
+#if defined(__SSSE3__)
+	// The number of input bytes examined by a single block_decode() call.
+	static constexpr size_t block_size = 64;
+
+	// Decode the integers that end within the next 64 input bytes. The
+	// caller must ensure that there are at least 64 more integers to be
+	// decoded, so the 64 bytes are readable and the output has room for
+	// all of them. Returns the number of decoded integers.
+	template <typename Iter>
+	static size_t block_decode(Iter &dst, src_bytes_t &src, value_codec &vcodec)
+	{
+		const __m128i *vsrc = reinterpret_cast<const __m128i *>(src);
+		const uint64_t mask = uint64_t(_mm_movemask_epi8(_mm_loadu_si128(vsrc)))
+			| uint64_t(_mm_movemask_epi8(_mm_loadu_si128(vsrc + 1))) << 16
+			| uint64_t(_mm_movemask_epi8(_mm_loadu_si128(vsrc + 2))) << 32
+			| uint64_t(_mm_movemask_epi8(_mm_loadu_si128(vsrc + 3))) << 48;
+
+		size_t npos = 0, nvalues = 0;
+		while (npos <= block_size - 16) {
+			const unsigned bits = unsigned(mask >> npos) & 0xffff;
+
+			// All the next 16 bytes are single-byte integers.
+			if (bits == 0) {
+				for (size_t i = 0; i < 16; i++)
+					*dst++ = vcodec.value_decode(unsigned_t(src[npos + i]));
+				npos += 16;
+				nvalues += 16;
+				continue;
+			}
+
+			const detail::varint_shuffle &entry
+				= detail::varint_shuffle_masks.entries[bits & 0xfff];
+			if (entry.nvalues == 0)
+				break;
+
+			const __m128i x = _mm_shuffle_epi8(
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + npos)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(entry.shuffle)));
+
+			// Squeeze out the continuation bits.
+			__m128i v = _mm_and_si128(x, _mm_set1_epi32(0x0000007f));
+			v = _mm_or_si128(v,
+					 _mm_and_si128(_mm_srli_epi32(x, 1),
+						       _mm_set1_epi32(0x00003f80)));
+			v = _mm_or_si128(v,
+					 _mm_and_si128(_mm_srli_epi32(x, 2),
+						       _mm_set1_epi32(0x001fc000)));
+			v = _mm_or_si128(v,
+					 _mm_and_si128(_mm_srli_epi32(x, 3),
+						       _mm_set1_epi32(0x0fe00000)));
+
+			alignas(16) uint32_t values[4];
+			_mm_store_si128(reinterpret_cast<__m128i *>(values), v);
+
+			// There is room for 4 integers so it is fine to store all
+			// the lanes and advance just by the decoded number.
+			Iter out = dst;
+			for (size_t i = 0; i < 4; i++)
+				*out++ = vcodec.value_decode(unsigned_t(values[i]));
+			std::advance(dst, entry.nvalues);
+
+			npos += entry.nbytes;
+			nvalues += entry.nvalues;
+		}
+
+		// Decode the rest of integers that end within the block one
+		// byte at a time. These are long integers that do not fit
+		// the shuffle table and integers near the block end.
+		const src_bytes_t limit = src + integer_traits<uint64_t>::usedcount(~mask);
+		for (src += npos; src < limit; nvalues++)
+			value_decode(*dst++, src, vcodec);
+		return nvalues;
+	}
+#endif
+
 	template <typename Iter>
 	static void
 	decode(Iter dst, Iter const end, src_bytes_t &src, value_codec vcodec = value_codec())
 	{
+#if defined(__SSSE3__)
+		// Every integer takes at least one byte so while there are
+		// enough integers left it is safe to load a full block.
+		for (auto n = std::distance(dst, end); size_t(n) >= block_size;)
+			n -= block_decode(dst, src, vcodec);
+#endif
 		while (dst != end)
 			value_decode(*dst++, src, vcodec);
 	}
+
+	// Skip over a given number of encoded integers.
+	static void skip(src_bytes_t &src, size_t nvalues)
+	{
+		while (nvalues)
+			if ((*src++ & 0x80) == 0)
+				nvalues--;
+	}
 };
 
 } // namespace oroch
@@ -0,0 +1,139 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <vector>
+
+#include <oroch/bitdic.h>
+
+// Pick one of a few distinct values that are far apart.
+static uint64_t
+tenant(uint64_t i, uint64_t ntenants)
+{
+	uint64_t h = i * 0xff51afd7ed558ccd;
+	h ^= h >> 29;
+	return (h % ntenants + 1) * 0x9e3779b97f4a7c15;
+}
+
+template <typename T>
+static void
+check_bitdic(const std::vector<T> &integers)
+{
+	using codec = oroch::bitdic_codec<T>;
+
+	typename codec::dictionary dict;
+	codec::build(dict, integers.begin(), integers.end());
+	const size_t nbits = codec::code_nbits(dict.size());
+
+	const size_t space = codec::space(integers.size(), nbits);
+	const auto bytes = check_codec<codec>(integers, space, dict, nbits);
+	check_decode_range<codec>(integers, bytes, {1, 63, 250, 600}, dict, nbits);
+
+	for (size_t i = 0; i < integers.size(); i += 7) {
+		const size_t code = codec::fetch_code(bytes.data(), i, nbits);
+		REQUIRE(dict[code] == integers[i]);
+	}
+}
+
+TEST_CASE("bitdic codec layout", "[bitdic]")
+{
+	using codec = oroch::bitdic_codec<int32_t>;
+	REQUIRE(codec::code_nbits(1) == 1);
+	REQUIRE(codec::code_nbits(2) == 1);
+	REQUIRE(codec::code_nbits(3) == 2);
+	REQUIRE(codec::code_nbits(37) == 6);
+
+	std::vector<int32_t> integers{{-1000000, 7, 7, 2000000, -1000000}};
+	codec::dictionary dict;
+	codec::build(dict, integers.begin(), integers.end());
+	REQUIRE(dict == codec::dictionary({-1000000, 7, 2000000}));
+
+	std::vector<uint8_t> bytes(codec::space(integers.size(), 2));
+	REQUIRE(bytes.size() == 16);
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), dict, 2);
+	// The codes 0, 1, 1, 2, 0.
+	REQUIRE(bytes[0] == 0x94);
+	REQUIRE(bytes[1] == 0x00);
+}
+
+TEST_CASE("bitdic codec for all types", "[bitdic]")
+{
+	for (size_t n : {0, 1, 2, 17, 255, 256, 257, 1000}) {
+		std::vector<uint64_t> values;
+		for (uint64_t i = 0; i < n; i++)
+			values.push_back(tenant(i, 37));
+		check_bitdic(std::vector<int8_t>(values.begin(), values.end()));
+		check_bitdic(std::vector<uint8_t>(values.begin(), values.end()));
+		check_bitdic(std::vector<int16_t>(values.begin(), values.end()));
+		check_bitdic(std::vector<uint16_t>(values.begin(), values.end()));
+		check_bitdic(std::vector<int32_t>(values.begin(), values.end()));
+		check_bitdic(std::vector<uint32_t>(values.begin(), values.end()));
+		check_bitdic(std::vector<int64_t>(values.begin(), values.end()));
+		check_bitdic(values);
+	}
+}
+
+TEST_CASE("bitdic codec estimate", "[bitdic]")
+{
+	using codec = oroch::bitdic_codec<uint64_t>;
+	for (size_t ntenants : {1, 10, 37, 300}) {
+		std::vector<uint64_t> integers;
+		for (uint64_t i = 0; i < 10000; i++)
+			integers.push_back(tenant(i, ntenants));
+		const size_t estimate
+			= codec::estimate(integers.begin(), integers.end(), 10000);
+		REQUIRE(estimate >= ntenants * 9 / 10);
+		REQUIRE(estimate <= ntenants * 11 / 10 + 1);
+	}
+
+	// It stops at the limit.
+	std::vector<uint64_t> integers;
+	for (uint64_t i = 0; i < 10000; i++)
+		integers.push_back(i);
+	REQUIRE(codec::estimate(integers.begin(), integers.end(), 100) == 100);
+
+	// It gives up on the limit if the bitmap gets full.
+	for (uint64_t i = 10000; i < 100000; i++)
+		integers.push_back(i);
+	REQUIRE(codec::estimate(integers.begin(), integers.end(), 65537) == 65537);
+}
+
+TEST_CASE("bitdic codec queries", "[bitdic]")
+{
+	using codec = oroch::bitdic_codec<int64_t>;
+	std::vector<int64_t> integers;
+	for (uint64_t i = 0; i < 1000; i++)
+		integers.push_back(int64_t(tenant(i, 20)));
+
+	codec::dictionary dict;
+	codec::build(dict, integers.begin(), integers.end());
+	const size_t nbits = codec::code_nbits(dict.size());
+	std::vector<uint8_t> bytes(codec::space(integers.size(), nbits));
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), dict, nbits);
+
+	for (int64_t value : {dict[0], dict[7], dict[19], dict[3] + 1}) {
+		size_t position = 0;
+		while (position < integers.size() && integers[position] != value)
+			position++;
+		REQUIRE(codec::find(bytes.data(), integers.size(), dict, value, nbits)
+			== position);
+	}
+
+	const int64_t lo = dict[3] - 1, hi = dict[11];
+	std::vector<uint64_t> bitmap((integers.size() + 63) / 64);
+	size_t count = 0;
+	for (int64_t value : integers)
+		count += (lo <= value && value <= hi);
+	REQUIRE(codec::count(bytes.data(), integers.size(), dict, lo, hi, nbits) == count);
+	REQUIRE(codec::scan(bitmap.data(), bytes.data(), integers.size(), dict, lo, hi, nbits)
+		== count);
+	for (size_t i = 0; i < integers.size(); i++) {
+		const bool bit = (bitmap[i / 64] >> (i % 64)) & 1;
+		REQUIRE(bit == (lo <= integers[i] && integers[i] <= hi));
+	}
+
+	// A range between dictionary values.
+	const int64_t gap_lo = dict[5] + 1, gap_hi = dict[6] - 1;
+	REQUIRE(codec::count(bytes.data(), integers.size(), dict, gap_lo, gap_hi, nbits) == 0);
+}
@@ -0,0 +1,109 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <oroch/bitdlt.h>
+
+// Find the delta parameters the same way integer_codec does.
+template <typename T>
+static void
+delta_params(const std::vector<T> &integers, size_t &nbits, T &origin)
+{
+	using traits = oroch::integer_traits<T>;
+	using signed_t = typename traits::signed_t;
+	using unsigned_t = typename traits::unsigned_t;
+
+	signed_t dmin = std::numeric_limits<signed_t>::max();
+	signed_t dmax = std::numeric_limits<signed_t>::min();
+	for (size_t i = 1; i < integers.size(); i++) {
+		const unsigned_t u = unsigned_t(integers[i]) - unsigned_t(integers[i - 1]);
+		const signed_t d = signed_t(u);
+		dmin = std::min(dmin, d);
+		dmax = std::max(dmax, d);
+	}
+	if (integers.size() < 2)
+		dmin = dmax = 0;
+	nbits = traits::usedcount(unsigned_t(unsigned_t(dmax) - unsigned_t(dmin)));
+	origin = T(dmin);
+}
+
+template <typename T>
+static void
+check_bitdlt(const std::vector<T> &integers)
+{
+	using codec = oroch::bitdlt_codec<T>;
+
+	size_t nbits;
+	T origin;
+	delta_params(integers, nbits, origin);
+
+	const size_t space = codec::space(integers.size(), nbits);
+	const auto bytes = check_codec<codec>(integers, space, nbits, origin);
+	check_decode_range<codec>(integers, bytes, {1, 130, 250, 600}, nbits, origin);
+}
+
+TEST_CASE("bitdlt codec layout", "[bitdlt]")
+{
+	using codec = oroch::bitdlt_codec<uint32_t>;
+	REQUIRE(codec::space(0, 3) == 0);
+	REQUIRE(codec::space(1, 3) == 4);
+	REQUIRE(codec::space(10, 0) == 4);
+	REQUIRE(codec::space(43, 3) == 4 + 16);
+	REQUIRE(codec::space(44, 3) == 4 + 32);
+
+	// The differences 3, 4, 5, 3 are packed relative to 3.
+	std::vector<uint32_t> integers{{100, 103, 107, 112, 115}};
+	std::vector<uint8_t> bytes(codec::space(integers.size(), 2));
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), 2, 3);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+	REQUIRE(bytes[0] == 100);
+	REQUIRE(bytes[4] == 0x24);
+}
+
+TEST_CASE("bitdlt codec for sorted values", "[bitdlt]")
+{
+	std::vector<uint32_t> integers;
+	for (uint32_t i = 0; i < 1000; i++)
+		integers.push_back(1000000 + i * 3 + (i * 7) % 5);
+	check_bitdlt(integers);
+
+	std::vector<int64_t> integers64;
+	for (int64_t i = 0; i < 1000; i++)
+		integers64.push_back(i - 100);
+	check_bitdlt(integers64);
+}
+
+TEST_CASE("bitdlt codec for all types", "[bitdlt]")
+{
+	for (size_t n : {0, 1, 2, 17, 255, 256, 257, 1000}) {
+		std::vector<uint64_t> values;
+		for (uint64_t i = 0; i < n; i++)
+			values.push_back(i * 0x9e3779b97f4a7c15 >> (i % 64));
+		check_bitdlt(std::vector<int8_t>(values.begin(), values.end()));
+		check_bitdlt(std::vector<uint8_t>(values.begin(), values.end()));
+		check_bitdlt(std::vector<int16_t>(values.begin(), values.end()));
+		check_bitdlt(std::vector<uint16_t>(values.begin(), values.end()));
+		check_bitdlt(std::vector<int32_t>(values.begin(), values.end()));
+		check_bitdlt(std::vector<uint32_t>(values.begin(), values.end()));
+		check_bitdlt(std::vector<int64_t>(values.begin(), values.end()));
+		check_bitdlt(values);
+	}
+}
+
+TEST_CASE("bitdlt codec for arithmetic progressions", "[bitdlt]")
+{
+	std::vector<int32_t> integers;
+	for (int32_t i = 0; i < 300; i++)
+		integers.push_back(50 - i * 7);
+	check_bitdlt(integers);
+
+	// The differences wrap around.
+	std::vector<uint16_t> integers16;
+	for (uint32_t i = 0; i < 300; i++)
+		integers16.push_back(uint16_t(i * 40000));
+	check_bitdlt(integers16);
+}
@@ -0,0 +1,67 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <vector>
+
+#include <oroch/bitdod.h>
+
+template <typename T>
+static void
+check_bitdod(const std::vector<T> &integers, size_t nbits)
+{
+	using codec = oroch::bitdod_codec<T>;
+	const size_t space = codec::space(integers.begin(), integers.end(), nbits);
+	const auto bytes = check_codec<codec>(integers, space, nbits);
+	check_decode_range<codec>(integers, bytes, {1, 2, 130, 258, 600}, nbits);
+}
+
+TEST_CASE("bitdod codec layout", "[bitdod]")
+{
+	using codec = oroch::bitdod_codec<uint32_t>;
+
+	std::vector<uint32_t> integers{{100, 110, 120, 130, 141}};
+	REQUIRE(codec::space(integers.begin(), integers.begin(), 2) == 0);
+	REQUIRE(codec::space(integers.begin(), integers.begin() + 1, 2) == 4);
+	REQUIRE(codec::space(integers.begin(), integers.begin() + 2, 2) == 8);
+
+	// A single chunk with the width of 2 and no exceptions.
+	std::vector<uint8_t> bytes(codec::space(integers.begin(), integers.end(), 2));
+	REQUIRE(bytes.size() == 8 + 2 + 16);
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), 2);
+	REQUIRE(bytes[0] == 100);
+	REQUIRE(bytes[4] == 10);
+	REQUIRE(bytes[8] == 2);
+	REQUIRE(bytes[9] == 0);
+	// The second differences 0, 0, 1 zigzag-encoded.
+	REQUIRE(bytes[10] == 0x20);
+}
+
+TEST_CASE("bitdod codec for timestamps", "[bitdod]")
+{
+	// Regular steps with rare late events.
+	std::vector<int64_t> integers;
+	for (int64_t i = 0; i < 1000; i++)
+		integers.push_back(1500000000000 + i * 1000 + (i % 97 ? 0 : 37));
+	check_bitdod(integers, 8);
+
+	std::vector<uint32_t> integers32(integers.begin(), integers.end());
+	check_bitdod(integers32, 8);
+}
+
+TEST_CASE("bitdod codec for all types", "[bitdod]")
+{
+	for (size_t n : {0, 1, 2, 3, 129, 258, 259, 1000}) {
+		std::vector<uint64_t> values;
+		for (uint64_t i = 0; i < n; i++)
+			values.push_back(i * i * 3 + (i * 0x9e3779b97f4a7c15 >> 61));
+		check_bitdod(std::vector<int8_t>(values.begin(), values.end()), 8);
+		check_bitdod(std::vector<uint8_t>(values.begin(), values.end()), 8);
+		check_bitdod(std::vector<int16_t>(values.begin(), values.end()), 16);
+		check_bitdod(std::vector<uint16_t>(values.begin(), values.end()), 16);
+		check_bitdod(std::vector<int32_t>(values.begin(), values.end()), 32);
+		check_bitdod(std::vector<uint32_t>(values.begin(), values.end()), 32);
+		check_bitdod(std::vector<int64_t>(values.begin(), values.end()), 64);
+		check_bitdod(values, 64);
+	}
+}
@@ -76,3 +76,61 @@ TEST_CASE("bitfor codec fetch", "[bitfor]")
 	for (unsigned int i = 0; i < INTS; i++)
 		REQUIRE(codec::fetch(bytes.begin(), i, params) == (i + FREF));
 }
+
+TEST_CASE("bitfor codec gather", "[bitfor]")
+{
+	using codec = oroch::bitfor_codec<uint32_t>;
+	std::array<uint8_t, codec::basic_codec::space(INTS, BITS)> bytes;
+	std::array<uint32_t, INTS> integers;
+	codec::parameters params(FREF, BITS);
+
+	for (int i = 0; i < INTS; i++)
+		integers[i] = i + FREF;
+
+	auto b_it = bytes.begin();
+	codec::encode(b_it, integers.begin(), integers.end(), params);
+
+	std::array<size_t, INTS> indices;
+	for (int i = 0; i < INTS; i++)
+		indices[i] = (i * 37) % INTS;
+
+	std::array<uint32_t, INTS> values;
+	codec::gather(bytes.begin(), indices.begin(), indices.end(), values.begin(), params);
+	for (int i = 0; i < INTS; i++)
+		REQUIRE(values[i] == indices[i] + FREF);
+}
+
+TEST_CASE("bitfor codec scan", "[bitfor]")
+{
+	using codec = oroch::bitfor_codec<int32_t>;
+	std::array<uint8_t, codec::basic_codec::space(INTS, BITS)> bytes;
+	std::array<int32_t, INTS> integers;
+	codec::parameters params(-FREF, BITS);
+
+	for (int i = 0; i < INTS; i++)
+		integers[i] = (i * 37) % INTS - FREF;
+
+	auto b_it = bytes.begin();
+	codec::encode(b_it, integers.begin(), integers.end(), params);
+
+	std::array<uint64_t, (INTS + 63) / 64> bitmap;
+	for (int32_t lo : {-2 * FREF, -FREF, -FREF + 5, -FREF + 200}) {
+		for (int32_t hi : {lo, lo + 10, -FREF - 1, 0}) {
+			size_t count = codec::scan(
+				bitmap.data(), bytes.begin(), INTS, lo, hi, params);
+			size_t first = codec::scan_first(bytes.begin(), INTS, lo, hi, params);
+
+			size_t expected_count = 0, expected_first = INTS;
+			for (size_t i = 0; i < INTS; i++) {
+				bool match = integers[i] >= lo && integers[i] <= hi;
+				REQUIRE(((bitmap[i / 64] >> (i % 64)) & 1) == match);
+				if (match && expected_count++ == 0)
+					expected_first = i;
+			}
+			REQUIRE(count == expected_count);
+			REQUIRE(first == expected_first);
+			REQUIRE(codec::count(bytes.begin(), INTS, lo, hi, params)
+				== expected_count);
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <vector>
+
+#include <oroch/bitlin.h>
+
+template <typename T>
+static void
+check_bitlin(const std::vector<T> &integers)
+{
+	using codec = oroch::bitlin_codec<T>;
+
+	const typename codec::parameters params = codec::fit(integers.begin(), integers.end());
+
+	const size_t space = codec::space(integers.size(), params.nbits);
+	const auto bytes = check_codec<codec>(integers, space, params);
+	check_decode_range<codec>(integers, bytes, {1, 63, 130, 250, 600}, params);
+	check_fetch<codec>(integers, bytes, params);
+}
+
+TEST_CASE("bitlin codec fit", "[bitlin]")
+{
+	using codec = oroch::bitlin_codec<int32_t>;
+
+	// An exact arithmetic progression takes no space.
+	std::vector<int32_t> integers;
+	for (int32_t i = 0; i < 256; i++)
+		integers.push_back(i - 100);
+	const auto params = codec::fit(integers.begin(), integers.end());
+	REQUIRE(params.origin == -100);
+	REQUIRE(params.slope == 1);
+	REQUIRE(params.nbits == 0);
+	REQUIRE(codec::space(integers.size(), params.nbits) == 0);
+	check_bitlin(integers);
+
+	// The origin is shifted so that the differences are not negative.
+	integers.clear();
+	for (int32_t i = 0; i < 256; i++)
+		integers.push_back(1000 - 5 * i + (i % 3 ? 0 : 6) - (i % 7 ? 0 : 2));
+	const auto params2 = codec::fit(integers.begin(), integers.end());
+	REQUIRE(params2.slope == -5);
+	REQUIRE(params2.nbits == 4);
+	check_bitlin(integers);
+}
+
+TEST_CASE("bitlin codec fit sample", "[bitlin]")
+{
+	using codec = oroch::bitlin_codec<int32_t>;
+	std::vector<int32_t> integers;
+	for (int32_t i = 0; i < 1024; i++)
+		integers.push_back(1000 - 5 * i + (i % 3 ? 0 : 6));
+	REQUIRE(codec::fit_slope(integers.begin(), integers.end()) == -5);
+
+	// Take runs of 4 integers at every 64 positions.
+	std::vector<int32_t> sample;
+	for (size_t pos = 0; pos < integers.size(); pos += 64)
+		sample.insert(sample.end(), &integers[pos], &integers[pos + 4]);
+	REQUIRE(codec::fit_sample(sample.begin(), sample.end(), 4, 64, 1000, -5) == 3);
+	REQUIRE(codec::fit_sample(sample.begin(), sample.end(), 4, 64, 1000, 0) > 3);
+	REQUIRE(codec::fit(integers.begin(), integers.end()).nbits == 3);
+}
+
+TEST_CASE("bitlin codec for all types", "[bitlin]")
+{
+	for (size_t n : {0, 1, 2, 17, 255, 256, 257, 1000}) {
+		std::vector<uint64_t> values;
+		for (uint64_t i = 0; i < n; i++)
+			values.push_back(i * 1234567 + (i * 0x9e3779b97f4a7c15 >> 60));
+		check_bitlin(std::vector<int8_t>(values.begin(), values.end()));
+		check_bitlin(std::vector<uint8_t>(values.begin(), values.end()));
+		check_bitlin(std::vector<int16_t>(values.begin(), values.end()));
+		check_bitlin(std::vector<uint16_t>(values.begin(), values.end()));
+		check_bitlin(std::vector<int32_t>(values.begin(), values.end()));
+		check_bitlin(std::vector<uint32_t>(values.begin(), values.end()));
+		check_bitlin(std::vector<int64_t>(values.begin(), values.end()));
+		check_bitlin(values);
+	}
+}
+
+TEST_CASE("bitlin codec for random values", "[bitlin]")
+{
+	// The line does not help but the values still round-trip.
+	std::vector<uint64_t> values;
+	for (uint64_t i = 0; i < 1000; i++)
+		values.push_back(i * 0x9e3779b97f4a7c15 >> (i % 64));
+	check_bitlin(values);
+	check_bitlin(std::vector<int16_t>(values.begin(), values.end()));
+}
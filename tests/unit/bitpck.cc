@@ -1,7 +1,11 @@
 #include "catch.hpp"
+#include "codec_check.h"
 
 #include <array>
+#include <vector>
+
 #include <oroch/bitpck.h>
+#include <oroch/origin.h>
 
 #define BITS 7
 #define INTS 128
@@ -72,3 +76,117 @@ TEST_CASE("bitpck codec fetch", "[bitpck]")
 		REQUIRE(codec::fetch(bytes.begin(), i, BITS) == i);
 	}
 }
+
+TEST_CASE("bitpck codec for 64-bit values of all widths", "[bitpck]")
+{
+	for (size_t nbits = 1; nbits <= 64; nbits++) {
+		const uint64_t mask = uint64_t(-1) >> (64 - nbits);
+		std::vector<uint64_t> integers;
+		for (uint64_t i = 0; i < 1500; i++)
+			integers.push_back((i * 0x9e3779b97f4a7c15) & mask);
+		integers[3] = mask;
+		const size_t space = oroch::bitpck_codec<uint64_t>::space(1500, nbits);
+		check_codec<oroch::bitpck_codec<uint64_t>>(integers, space, nbits);
+
+		std::vector<int64_t> signed_integers;
+		for (uint64_t value : integers)
+			signed_integers.push_back(oroch::zigzag_codec<int64_t>::decode(value));
+		check_codec<oroch::bitpck_codec<int64_t>>(signed_integers, space, nbits);
+
+		const oroch::origin_codec<int64_t> vcodec(-1000000);
+		std::vector<int64_t> shifted_integers;
+		for (uint64_t value : integers)
+			shifted_integers.push_back(int64_t(value) - 1000000);
+		check_codec<oroch::bitpck_codec<int64_t, oroch::origin_codec<int64_t>>>(
+			shifted_integers, space, nbits, vcodec);
+	}
+}
+
+TEST_CASE("bitpck codec gather", "[bitpck]")
+{
+	using codec = oroch::bitpck_codec<int64_t>;
+	std::vector<int64_t> integers;
+	for (int64_t i = 0; i < 1000; i++)
+		integers.push_back(i % 3 ? i * 1000 : -i * 1000);
+
+	// Positions in random order with repeats and enough of them to
+	// fill a few batches.
+	std::vector<size_t> indices;
+	for (size_t i = 0; i < 300; i++)
+		indices.push_back((i * 7919) % integers.size());
+
+	for (size_t nbits : {21, 64}) {
+		std::vector<uint8_t> bytes(codec::space(integers.size(), nbits));
+		oroch::dst_bytes_t d_it = bytes.data();
+		codec::encode(d_it, integers.begin(), integers.end(), nbits);
+
+		std::vector<int64_t> values(indices.size());
+		codec::gather(
+			bytes.data(), indices.begin(), indices.end(), values.begin(), nbits);
+		for (size_t i = 0; i < indices.size(); i++)
+			REQUIRE(values[i] == integers[indices[i]]);
+	}
+}
+
+TEST_CASE("bitpck codec decode range", "[bitpck]")
+{
+	using codec = oroch::bitpck_codec<uint32_t>;
+	std::array<uint8_t, codec::space(INTS, BITS)> bytes;
+	std::array<uint32_t, INTS> integers;
+	for (int i = 0; i < INTS; i++)
+		integers[i] = i;
+
+	oroch::dst_bytes_t d_it = bytes.begin();
+	codec::encode(d_it, integers.begin(), integers.end(), BITS);
+
+	// The block capacity is 18 so this covers a range within a block,
+	// a range that starts at a block boundary and a range that starts
+	// in the middle of a block and spans a few more.
+	for (size_t first : {3, 18, 20}) {
+		for (size_t last : {first + 5, size_t(INTS)}) {
+			std::vector<uint32_t> values(last - first);
+			codec::decode_range(values.begin(), values.end(), bytes.begin(), first,
+					    BITS);
+			for (size_t i = first; i < last; i++)
+				REQUIRE(values[i - first] == integers[i]);
+		}
+	}
+}
+
+TEST_CASE("bitpck codec scan", "[bitpck]")
+{
+	using codec = oroch::bitpck_codec<uint64_t>;
+	const size_t nvalues = 300;
+
+	for (size_t nbits = 1; nbits <= 64; nbits++) {
+		INFO("nbits: " << nbits);
+		const uint64_t mask = uint64_t(-1) >> (64 - nbits);
+		std::vector<uint64_t> integers(nvalues);
+		for (size_t i = 0; i < nvalues; i++)
+			integers[i] = (i * i * 0x9e3779b97f4a7c15ull) % 13 * (mask / 12) & mask;
+
+		std::vector<uint8_t> bytes(codec::space(nvalues, nbits));
+		oroch::dst_bytes_t d_it = bytes.data();
+		codec::encode(d_it, integers.begin(), integers.end(), nbits);
+
+		for (uint64_t lo : {uint64_t(0), integers[7], integers[nvalues - 1], mask}) {
+			for (uint64_t hi : {lo, lo + mask / 3, mask}) {
+				std::vector<uint64_t> bitmap((nvalues + 63) / 64, -1);
+				size_t count = codec::scan(
+					bitmap.data(), bytes.data(), nvalues, lo, hi, nbits);
+				size_t first = codec::scan_first(
+					bytes.data(), nvalues, lo, hi, nbits);
+
+				size_t expected_count = 0, expected_first = nvalues;
+				for (size_t i = 0; i < nvalues; i++) {
+					bool match = integers[i] >= lo && integers[i] <= hi;
+					REQUIRE(((bitmap[i / 64] >> (i % 64)) & 1) == match);
+					if (match && expected_count++ == 0)
+						expected_first = i;
+				}
+				REQUIRE(count == expected_count);
+				REQUIRE(first == expected_first);
+			}
+		}
+	}
+}
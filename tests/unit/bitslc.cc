@@ -0,0 +1,102 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <array>
+#include <vector>
+
+#include <oroch/bitslc.h>
+#include <oroch/origin.h>
+
+TEST_CASE("bitslc codec layout", "[bitslc]")
+{
+	using codec = oroch::bitslc_codec<uint32_t>;
+	REQUIRE(codec::space(0, 3) == 0);
+	REQUIRE(codec::space(1, 3) == 24);
+	REQUIRE(codec::space(64, 3) == 24);
+	REQUIRE(codec::space(65, 3) == 48);
+
+	// The most significant bits go first.
+	std::array<uint8_t, codec::space(3, 3)> bytes;
+	std::array<uint32_t, 3> integers{{4, 1, 7}};
+
+	oroch::dst_bytes_t d_it = bytes.begin();
+	codec::encode(d_it, integers.begin(), integers.end(), 3);
+	REQUIRE(d_it == bytes.end());
+	REQUIRE(bytes[0] == 0x05);
+	REQUIRE(bytes[8] == 0x04);
+	REQUIRE(bytes[16] == 0x06);
+	REQUIRE(bytes[1] == 0x00);
+}
+
+TEST_CASE("bitslc codec for all widths", "[bitslc]")
+{
+	for (size_t nbits = 1; nbits <= 64; nbits++) {
+		const uint64_t mask = uint64_t(-1) >> (64 - nbits);
+		std::vector<uint64_t> integers;
+		for (uint64_t i = 0; i < 200; i++)
+			integers.push_back((i * 0x9e3779b97f4a7c15) & mask);
+		integers[5] = mask;
+		using codec = oroch::bitslc_codec<uint64_t>;
+		const auto bytes
+			= check_codec<codec>(integers, codec::space(200, nbits), nbits);
+		check_fetch<codec>(integers, bytes, nbits);
+		check_decode_range<codec>(integers, bytes, {70}, nbits);
+	}
+}
+
+TEST_CASE("bitslc codec with frame of reference", "[bitslc]")
+{
+	std::vector<int32_t> integers;
+	for (int32_t i = 0; i < 150; i++)
+		integers.push_back(-1000 + (i * 37) % 300);
+	using codec = oroch::bitslc_codec<int32_t, oroch::origin_codec<int32_t>>;
+	const oroch::origin_codec<int32_t> vcodec(-1000);
+	const auto bytes = check_codec<codec>(integers, codec::space(150, 9), 9, vcodec);
+	check_fetch<codec>(integers, bytes, 9, vcodec);
+	check_decode_range<codec>(integers, bytes, {70}, 9, vcodec);
+}
+
+TEST_CASE("bitslc codec scan", "[bitslc]")
+{
+	using codec = oroch::bitslc_codec<uint64_t>;
+	const size_t nvalues = 300;
+
+	for (size_t nbits : {1, 5, 17, 64}) {
+		INFO("nbits: " << nbits);
+		const uint64_t mask = uint64_t(-1) >> (64 - nbits);
+		std::vector<uint64_t> integers(nvalues);
+		for (size_t i = 0; i < nvalues; i++)
+			integers[i] = (i * i * 0x9e3779b97f4a7c15ull) % 13 * (mask / 12) & mask;
+
+		std::vector<uint8_t> bytes(codec::space(nvalues, nbits));
+		oroch::dst_bytes_t d_it = bytes.data();
+		codec::encode(d_it, integers.begin(), integers.end(), nbits);
+
+		for (uint64_t lo : {uint64_t(0), integers[7], integers[nvalues - 1], mask}) {
+			for (uint64_t hi : {lo, lo + mask / 3, mask}) {
+				std::vector<uint64_t> bitmap((nvalues + 63) / 64);
+				size_t count = codec::scan(
+					bitmap.data(), bytes.data(), nvalues, lo, hi, nbits);
+
+				size_t expected_count = 0, expected_first = nvalues;
+				uint64_t expected_sum = 0;
+				for (size_t i = 0; i < nvalues; i++) {
+					bool match = integers[i] >= lo && integers[i] <= hi;
+					REQUIRE(((bitmap[i / 64] >> (i % 64)) & 1) == match);
+					if (!match)
+						continue;
+					if (expected_count++ == 0)
+						expected_first = i;
+					expected_sum += integers[i];
+				}
+				REQUIRE(count == expected_count);
+				REQUIRE(codec::count(bytes.data(), nvalues, lo, hi, nbits)
+					== expected_count);
+				REQUIRE(codec::scan_first(bytes.data(), nvalues, lo, hi, nbits)
+					== expected_first);
+				REQUIRE(codec::sum(bytes.data(), nvalues, lo, hi, nbits)
+					== expected_sum);
+			}
+		}
+	}
+}
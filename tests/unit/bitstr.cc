@@ -0,0 +1,91 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <array>
+#include <vector>
+
+#include <oroch/bitstr.h>
+#include <oroch/origin.h>
+
+TEST_CASE("bitstr codec layout", "[bitstr]")
+{
+	using codec = oroch::bitstr_codec<uint32_t>;
+	REQUIRE(codec::space(0, 3) == 0);
+	REQUIRE(codec::space(21, 3) == 8);
+	REQUIRE(codec::space(22, 3) == 16);
+	REQUIRE(codec::space(64, 7) == 56);
+
+	// Integers cross word boundaries.
+	std::array<uint8_t, codec::space(3, 30)> bytes;
+	std::array<uint32_t, 3> integers{{1, 2, 0x3fffffff}};
+
+	oroch::dst_bytes_t d_it = bytes.begin();
+	codec::encode(d_it, integers.begin(), integers.end(), 30);
+	REQUIRE(d_it == bytes.end());
+	REQUIRE(bytes[0] == 0x01);
+	REQUIRE(bytes[3] == 0x80);
+	REQUIRE(bytes[7] == 0xf0);
+	REQUIRE(bytes[8] == 0xff);
+	REQUIRE(bytes[11] == 0x03);
+	REQUIRE(bytes[12] == 0x00);
+}
+
+TEST_CASE("bitstr codec for all widths", "[bitstr]")
+{
+	for (size_t nbits = 1; nbits <= 64; nbits++) {
+		const uint64_t mask = uint64_t(-1) >> (64 - nbits);
+		std::vector<uint64_t> integers;
+		for (uint64_t i = 0; i < 200; i++)
+			integers.push_back((i * 0x9e3779b97f4a7c15) & mask);
+		integers[5] = mask;
+		using codec = oroch::bitstr_codec<uint64_t>;
+		const auto bytes
+			= check_codec<codec>(integers, codec::space(200, nbits), nbits);
+		check_fetch<codec>(integers, bytes, nbits);
+	}
+}
+
+TEST_CASE("bitstr codec for signed values", "[bitstr]")
+{
+	std::vector<int32_t> integers;
+	for (int32_t i = 0; i < 150; i++)
+		integers.push_back(i % 2 ? i : -i);
+	using codec = oroch::bitstr_codec<int32_t>;
+	const auto bytes = check_codec<codec>(integers, codec::space(150, 9), 9);
+	check_fetch<codec>(integers, bytes, 9);
+
+	std::vector<int16_t> integers16(integers.begin(), integers.end());
+	using codec16 = oroch::bitstr_codec<int16_t>;
+	const auto bytes16 = check_codec<codec16>(integers16, codec16::space(150, 9), 9);
+	check_fetch<codec16>(integers16, bytes16, 9);
+}
+
+TEST_CASE("bitstr codec with frame of reference", "[bitstr]")
+{
+	std::vector<int64_t> integers;
+	for (int64_t i = 0; i < 130; i++)
+		integers.push_back(i * 3 - 1000);
+	using codec = oroch::bitstr_codec<int64_t, oroch::origin_codec<int64_t>>;
+	const oroch::origin_codec<int64_t> vcodec(-1000);
+	const auto bytes = check_codec<codec>(integers, codec::space(130, 9), 9, vcodec);
+	check_fetch<codec>(integers, bytes, 9, vcodec);
+}
+
+TEST_CASE("bitstr codec fetch at the stream end", "[bitstr]")
+{
+	using codec = oroch::bitstr_codec<uint64_t>;
+	const uint64_t mask57 = uint64_t(-1) >> 7;
+	for (size_t nbits : {8, 57, 58, 64}) {
+		const uint64_t mask = uint64_t(-1) >> (64 - nbits);
+		std::array<uint64_t, 9> integers;
+		for (size_t i = 0; i < integers.size(); i++)
+			integers[i] = (mask57 - i) & mask;
+
+		// The buffer is exactly sized so every load must stay within it.
+		std::vector<uint8_t> bytes(codec::space(integers.size(), nbits));
+		oroch::dst_bytes_t d_it = bytes.data();
+		codec::encode(d_it, integers.begin(), integers.end(), nbits);
+		for (size_t i = 0; i < integers.size(); i++)
+			REQUIRE(codec::fetch(bytes.data(), i, nbits) == integers[i]);
+	}
+}
@@ -0,0 +1,107 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <array>
+#include <vector>
+
+#include <oroch/bitvec.h>
+#include <oroch/origin.h>
+
+#define FREF 1000
+
+TEST_CASE("bitvec codec layout", "[bitvec]")
+{
+	using codec = oroch::bitvec_codec<uint32_t>;
+	REQUIRE(codec::space(1, 1) == 16);
+	REQUIRE(codec::space(128, 7) == 112);
+	REQUIRE(codec::space(129, 7) == 224);
+
+	std::array<uint8_t, codec::space(128, 1)> bytes;
+	std::array<uint32_t, 128> integers{};
+	// The integers 0 and 5 go to the first bits of lanes 0 and 1.
+	integers[0] = 1;
+	integers[5] = 1;
+
+	oroch::dst_bytes_t d_it = bytes.begin();
+	codec::encode(d_it, integers.begin(), integers.end(), 1);
+	REQUIRE(d_it == bytes.end());
+	REQUIRE(bytes[0] == 0x01);
+	REQUIRE(bytes[4] == 0x02);
+	for (size_t i = 0; i < bytes.size(); i++) {
+		if (i != 0 && i != 4)
+			REQUIRE(bytes[i] == 0);
+	}
+}
+
+TEST_CASE("bitvec codec for all widths", "[bitvec]")
+{
+	using codec = oroch::bitvec_codec<uint32_t>;
+	for (size_t nbits = 1; nbits <= 32; nbits++) {
+		INFO("nbits: " << nbits);
+		uint32_t mask = uint32_t(-1) >> (32 - nbits);
+		// Two full blocks and a partial one.
+		std::vector<uint32_t> integers;
+		for (uint32_t i = 0; i < 300; i++)
+			integers.push_back((i * 2654435761u) & mask);
+		integers[7] = mask;
+		integers[299] = mask;
+		const auto bytes
+			= check_codec<codec>(integers, codec::space(300, nbits), nbits);
+		check_fetch<codec>(integers, bytes, nbits);
+	}
+}
+
+TEST_CASE("bitvec codec for signed values", "[bitvec]")
+{
+	std::vector<int32_t> integers;
+	for (int32_t i = 0; i < 200; i++)
+		integers.push_back(i % 2 ? i : -i);
+	using codec = oroch::bitvec_codec<int32_t>;
+	const auto bytes = check_codec<codec>(integers, codec::space(200, 9), 9);
+	check_fetch<codec>(integers, bytes, 9);
+
+	std::vector<int64_t> integers64(integers.begin(), integers.end());
+	using codec64 = oroch::bitvec_codec<int64_t>;
+	const auto bytes64 = check_codec<codec64>(integers64, codec64::space(200, 9), 9);
+	check_fetch<codec64>(integers64, bytes64, 9);
+}
+
+TEST_CASE("bitvec codec with frame of reference", "[bitvec]")
+{
+	std::vector<int32_t> integers;
+	for (int32_t i = 0; i < 256; i++)
+		integers.push_back(i - FREF);
+	using codec = oroch::bitvec_codec<int32_t, oroch::origin_codec<int32_t>>;
+	const oroch::origin_codec<int32_t> vcodec(-FREF);
+	const auto bytes = check_codec<codec>(integers, codec::space(256, 8), 8, vcodec);
+	check_fetch<codec>(integers, bytes, 8, vcodec);
+
+	std::vector<uint64_t> integers64;
+	for (uint64_t i = 0; i < 256; i++)
+		integers64.push_back((i << 20) + 0x100000000 + FREF);
+	using codec64 = oroch::bitvec_codec<uint64_t, oroch::origin_codec<uint64_t>>;
+	const oroch::origin_codec<uint64_t> vcodec64(0x100000000 + FREF);
+	const auto bytes64
+		= check_codec<codec64>(integers64, codec64::space(256, 28), 28, vcodec64);
+	check_fetch<codec64>(integers64, bytes64, 28, vcodec64);
+}
+
+TEST_CASE("bitvec codec scan first", "[bitvec]")
+{
+	using codec = oroch::bitvec_codec<uint32_t>;
+	std::array<uint32_t, 300> integers;
+	for (size_t i = 0; i < integers.size(); i++)
+		integers[i] = (i * 37) % 100;
+	integers[250] = 1000;
+
+	std::array<uint8_t, codec::space(300, 10)> bytes;
+	oroch::dst_bytes_t d_it = bytes.begin();
+	codec::encode(d_it, integers.begin(), integers.end(), 10);
+
+	REQUIRE(codec::scan_first(bytes.begin(), 300, 0, 0, 10) == 0);
+	REQUIRE(codec::scan_first(bytes.begin(), 300, 37, 37, 10) == 1);
+	REQUIRE(codec::scan_first(bytes.begin(), 300, 1000, 1000, 10) == 250);
+	REQUIRE(codec::scan_first(bytes.begin(), 300, 500, 999, 10) == 300);
+	REQUIRE(codec::scan_first(bytes.begin(), 300, 1024, 5000, 10) == 300);
+	REQUIRE(codec::scan_first(bytes.begin(), 250, 1000, 1000, 10) == 250);
+}
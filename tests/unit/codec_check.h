@@ -0,0 +1,86 @@
+// codec_check.h
+//
+// Round-trip checks shared by the codec tests. The codec is given as the
+// first template argument and the codec parameters go last in the same
+// order as for the codec functions.
+//
+
+#ifndef OROCH_TESTS_CODEC_CHECK_H_
+#define OROCH_TESTS_CODEC_CHECK_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <vector>
+
+#include <oroch/common.h>
+
+#include "catch.hpp"
+
+// Make integers of random bit lengths from zero to the full width.
+template <typename T>
+static std::vector<T>
+random_integers(size_t n)
+{
+	std::vector<T> integers(n);
+	for (size_t i = 0; i < n; i++) {
+		int nbits = random() % (sizeof(T) * 8 + 1);
+		uint64_t value = (uint64_t(random()) << 32) ^ uint64_t(random());
+		integers[i] = nbits ? T(value >> (64 - nbits)) : T(0);
+	}
+	return integers;
+}
+
+// Encode integers into a buffer of a given size, check that they take
+// exactly all of it and decode them back. The buffer is returned for
+// further checks.
+template <typename Codec, typename T, typename... Args>
+static std::vector<uint8_t>
+check_codec(const std::vector<T> &integers, size_t space, const Args &... args)
+{
+	std::vector<uint8_t> bytes(space);
+	oroch::dst_bytes_t d_it = bytes.data();
+	Codec::encode(d_it, integers.begin(), integers.end(), args...);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	std::vector<T> integers2(integers.size());
+	oroch::src_bytes_t s_it = bytes.data();
+	Codec::decode(integers2.begin(), integers2.end(), s_it, args...);
+	REQUIRE(s_it == bytes.data() + bytes.size());
+	for (size_t i = 0; i < integers.size(); i++)
+		REQUIRE(integers2[i] == integers[i]);
+
+	return bytes;
+}
+
+// Decode the integers from a few positions to the end.
+template <typename Codec, typename T, typename... Args>
+static void
+check_decode_range(const std::vector<T> &integers,
+		   const std::vector<uint8_t> &bytes,
+		   std::initializer_list<size_t> firsts,
+		   const Args &... args)
+{
+	for (size_t first : firsts) {
+		if (first >= integers.size())
+			continue;
+		std::vector<T> integers2(integers.size() - first);
+		Codec::decode_range(
+			integers2.begin(), integers2.end(), bytes.data(), first, args...);
+		for (size_t i = 0; i < integers2.size(); i++)
+			REQUIRE(integers2[i] == integers[i + first]);
+	}
+}
+
+// Fetch every integer on its own.
+template <typename Codec, typename T, typename... Args>
+static void
+check_fetch(const std::vector<T> &integers,
+	    const std::vector<uint8_t> &bytes,
+	    const Args &... args)
+{
+	for (size_t i = 0; i < integers.size(); i++)
+		REQUIRE(Codec::fetch(bytes.data(), i, args...) == integers[i]);
+}
+
+#endif /* OROCH_TESTS_CODEC_CHECK_H_ */
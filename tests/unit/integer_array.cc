@@ -1,5 +1,8 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <vector>
+
 #include <oroch/integer_array.h>
 
 using int32_array = oroch::integer_array<int32_t>;
@@ -29,4 +32,88 @@ TEST_CASE("large integer array", "[array]")
 	for (size_t i = 0; i < n; i++)
 		REQUIRE(array.find(i) == (i + 1));
 	REQUIRE(array.find(-1) == 0);
+	for (size_t i = 0; i < n; i++)
+		REQUIRE(array[i + 1] == int32_t(i));
+	REQUIRE(array[0] == -1);
+}
+
+TEST_CASE("sparse integer array", "[array]")
+{
+	const size_t n = 10000;
+	int32_array array;
+	for (size_t i = 0; i < n; i++)
+		array.insert(i, (i % 3) ? i : i * i * 7);
+	for (size_t i = 0; i < n; i++) {
+		REQUIRE(array[i] == int32_t((i % 3) ? i : i * i * 7));
+		REQUIRE(array.at(i) == int32_t((i % 3) ? i : i * i * 7));
+	}
+	REQUIRE(array.find(9999 * 9999 * 7) == 9999);
+}
+
+TEST_CASE("integer array with runs", "[array]")
+{
+	const size_t n = 10000;
+	int32_array array;
+	for (size_t i = 0; i < n; i++)
+		array.insert(i, 404 - int32_t(i / 300 % 4));
+	for (size_t i = 0; i < n; i++)
+		REQUIRE(array[i] == 404 - int32_t(i / 300 % 4));
+	REQUIRE(array.find(404) == 0);
+	REQUIRE(array.find(402) == 600);
+	REQUIRE(array.find(400) == oroch::not_found);
+}
+
+TEST_CASE("integer array with a dictionary", "[array]")
+{
+	const size_t n = 10000;
+	oroch::integer_array<int64_t> array;
+	for (size_t i = 0; i < n; i++)
+		array.insert(i, int64_t((i * 13 % 11 + 1) * 0x9e3779b97f4a7c15));
+	for (size_t i = 0; i < n; i++)
+		REQUIRE(array[i] == int64_t((i * 13 % 11 + 1) * 0x9e3779b97f4a7c15));
+	REQUIRE(array.find(int64_t(3 * 0x9e3779b97f4a7c15)) == 1);
+	REQUIRE(array.find(int64_t(12 * 0x9e3779b97f4a7c15)) == oroch::not_found);
+}
+
+TEST_CASE("integer array with vertical bit-packing", "[array]")
+{
+	const size_t n = 1024;
+	int32_array array;
+	std::vector<int32_t> values;
+	for (size_t i = 0; i < n; i++) {
+		values.push_back(int32_t(i * 37 % 1000) - 5000);
+		array.insert(i, values.back());
+	}
+	for (int32_t value : {-5000, -4963, -4001, -4000, 0}) {
+		auto it = std::find(values.begin(), values.end(), value);
+		size_t expected = it == values.end() ? oroch::not_found
+						      : std::distance(values.begin(), it);
+		REQUIRE(array.find(value) == expected);
+	}
+}
+
+TEST_CASE("integer array with pooled exceptions", "[array]")
+{
+	const size_t n = 10000;
+	int32_array array;
+	std::vector<int32_t> values;
+	for (size_t i = 0; i < n; i++) {
+		values.push_back((i % 97) ? int32_t(i * 7 % 13) : int32_t(100000 + i));
+		array.insert(i, values.back());
+	}
+	// Shift the values through all the pages.
+	array.insert(5, -1);
+	values.insert(values.begin() + 5, -1);
+	// And through the pages after the second one only.
+	array.insert(4096 + 4000, -2);
+	values.insert(values.begin() + 4096 + 4000, -2);
+
+	REQUIRE(array.size() == n + 2);
+	for (size_t i = 0; i < n + 2; i++)
+		REQUIRE(array.at(i) == values[i]);
+	REQUIRE(array.find(-1) == 5);
+	REQUIRE(array.find(-2) == 4096 + 4000);
+	REQUIRE(array.find(100000 + 97 * 50) == 97 * 50 + 1);
+	REQUIRE(array.find(100000 + 97 * 100) == 97 * 100 + 2);
+	REQUIRE(array.find(99999) == oroch::not_found);
 }
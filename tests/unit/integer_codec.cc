@@ -1,5 +1,6 @@
 #include "catch.hpp"
 
+#include <algorithm>
 #include <array>
 #include <oroch/integer_codec.h>
 
@@ -61,3 +62,693 @@ TEST_CASE("integer codec metadata", "[codec]")
 	meta2.decode(b_it);
 	REQUIRE(meta2.value_desc.encoding == meta.value_desc.encoding);
 }
+
+TEST_CASE("integer codec selects svbyte", "[codec]")
+{
+	using codec = oroch::integer_codec<uint32_t>;
+	std::array<uint32_t, INTS> integers;
+	std::array<uint32_t, INTS> integers2;
+	for (int i = 0; i < INTS; i++)
+		integers[i] = (i % 2) ? 128 + (i % 128) : 16384 + i * 256;
+
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end());
+	REQUIRE(meta.value_desc.encoding == oroch::encoding_t::svbyte);
+
+	std::vector<uint8_t> bytes(meta.dataspace());
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), meta);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	oroch::src_bytes_t b_it = bytes.data();
+	codec::decode(integers2.begin(), integers2.end(), b_it, meta);
+	for (int i = 0; i < INTS; i++)
+		REQUIRE(integers2[i] == integers[i]);
+}
+
+TEST_CASE("integer codec selects bitvec", "[codec]")
+{
+	using codec = oroch::integer_codec<int32_t>;
+	std::array<int32_t, 256> integers;
+	std::array<int32_t, 256> integers2;
+	for (int i = 0; i < 256; i++)
+		integers[i] = 1000 + (i * 37) % 1024;
+
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end());
+	REQUIRE(meta.value_desc.encoding == oroch::encoding_t::bitvec);
+	REQUIRE(meta.value_desc.nbits == 10);
+
+	std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+	oroch::dst_bytes_t d_it = bytes.data();
+	meta.encode(d_it);
+	codec::encode(d_it, integers.begin(), integers.end(), meta);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	codec::metadata meta2;
+	oroch::src_bytes_t b_it = bytes.data();
+	meta2.decode(b_it);
+	REQUIRE(meta2.value_desc.encoding == oroch::encoding_t::bitvec);
+	REQUIRE(meta2.value_desc.origin == 1000);
+
+	for (int i = 0; i < 256; i++)
+		REQUIRE(codec::fetch(b_it, i, meta2) == integers[i]);
+
+	codec::decode(integers2.begin(), integers2.end(), b_it, meta2);
+	for (int i = 0; i < 256; i++)
+		REQUIRE(integers2[i] == integers[i]);
+}
+
+TEST_CASE("integer codec fetch", "[codec]")
+{
+	using codec = oroch::integer_codec<int64_t>;
+	std::array<int64_t, INTS> integers;
+	for (int i = 0; i < INTS; i++)
+		integers[i] = (i % 2) ? i : -int64_t(i) * i * i * i * i;
+
+	for (size_t stride : {0, 16}) {
+		codec::metadata meta;
+		codec::select(meta, integers.begin(), integers.end(), stride);
+		REQUIRE(codec::has_fetch(meta));
+		REQUIRE(meta.value_desc.stride == stride);
+
+		std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+		oroch::dst_bytes_t d_it = bytes.data();
+		meta.encode(d_it);
+		REQUIRE(d_it == bytes.data() + meta.metaspace());
+		codec::encode(d_it, integers.begin(), integers.end(), meta);
+		REQUIRE(d_it == bytes.data() + bytes.size());
+
+		codec::metadata meta2;
+		oroch::src_bytes_t b_it = bytes.data();
+		meta2.decode(b_it);
+		REQUIRE(meta2.value_desc.encoding == meta.value_desc.encoding);
+		REQUIRE(meta2.value_desc.stride == stride);
+
+		for (int i = 0; i < INTS; i++)
+			REQUIRE(codec::fetch(b_it, i, meta2) == integers[i]);
+	}
+}
+
+TEST_CASE("integer codec scan", "[codec]")
+{
+	using codec = oroch::integer_codec<int32_t>;
+	std::array<int32_t, 200> integers;
+	for (int i = 0; i < 200; i++)
+		integers[i] = -100 + (i * 37) % 1000;
+
+	codec::metadata meta;
+	codec::select_sliced(meta, integers.begin(), integers.end());
+	REQUIRE(meta.value_desc.encoding == oroch::encoding_t::bitslc);
+	REQUIRE(codec::has_scan(meta));
+
+	std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+	oroch::dst_bytes_t d_it = bytes.data();
+	meta.encode(d_it);
+	codec::encode(d_it, integers.begin(), integers.end(), meta);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	codec::metadata meta2;
+	oroch::src_bytes_t b_it = bytes.data();
+	meta2.decode(b_it);
+	REQUIRE(meta2.value_desc.encoding == oroch::encoding_t::bitslc);
+
+	std::array<int32_t, 200> integers2;
+	oroch::src_bytes_t s_it = b_it;
+	codec::decode(integers2.begin(), integers2.end(), s_it, meta2);
+	for (int i = 0; i < 200; i++) {
+		REQUIRE(integers2[i] == integers[i]);
+		REQUIRE(codec::fetch(b_it, i, meta2) == integers[i]);
+	}
+
+	std::array<uint64_t, 4> bitmap;
+	for (int32_t lo : {-1000, -100, 0, 500}) {
+		for (int32_t hi : {lo, lo + 100, 1000}) {
+			size_t expected = 0;
+			for (int i = 0; i < 200; i++)
+				expected += integers[i] >= lo && integers[i] <= hi;
+			REQUIRE(codec::scan(bitmap.data(), b_it, 200, lo, hi, meta2)
+				== expected);
+			REQUIRE(codec::count(b_it, 200, lo, hi, meta2) == expected);
+			for (int i = 0; i < 200; i++)
+				REQUIRE(((bitmap[i / 64] >> (i % 64)) & 1)
+					== (integers[i] >= lo && integers[i] <= hi));
+		}
+	}
+}
+
+TEST_CASE("integer codec selects optpfd", "[codec]")
+{
+	using codec = oroch::integer_codec<int32_t>;
+	std::array<int32_t, INTS> integers;
+	std::array<int32_t, INTS> integers2;
+	for (int i = 0; i < INTS; i++)
+		integers[i] = (i % 7) ? 1 + i % 4 : i * i * 100;
+
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end());
+	REQUIRE(meta.value_desc.encoding == oroch::encoding_t::optpfd);
+	REQUIRE(codec::has_fetch(meta));
+
+	std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+	oroch::dst_bytes_t d_it = bytes.data();
+	meta.encode(d_it);
+	codec::encode(d_it, integers.begin(), integers.end(), meta);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	codec::metadata meta2;
+	oroch::src_bytes_t b_it = bytes.data();
+	meta2.decode(b_it);
+	REQUIRE(meta2.value_desc.encoding == oroch::encoding_t::optpfd);
+
+	for (int i = 0; i < INTS; i++)
+		REQUIRE(codec::fetch(b_it, i, meta2) == integers[i]);
+
+	codec::decode(integers2.begin(), integers2.end(), b_it, meta2);
+	for (int i = 0; i < INTS; i++)
+		REQUIRE(integers2[i] == integers[i]);
+}
+
+TEST_CASE("integer codec selects optpfd for mixed chunks", "[codec]")
+{
+	// Every fifth chunk takes a bit per value and the rest take 20 bits.
+	// The widths are picked per chunk so this wins even though the
+	// narrow values are too few to look like outliers on the whole.
+	using codec = oroch::integer_codec<uint32_t>;
+	std::vector<uint32_t> integers(64 * INTS);
+	for (uint32_t i = 0; i < 64 * INTS; i++) {
+		const uint32_t h = i * 2654435761u;
+		integers[i] = (i / INTS % 5) ? h >> 12 : h & 1;
+	}
+
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end());
+	REQUIRE(meta.value_desc.encoding == oroch::encoding_t::optpfd);
+
+	std::vector<uint8_t> bytes(meta.dataspace());
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), meta);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	std::vector<uint32_t> integers2(integers.size());
+	oroch::src_bytes_t b_it = bytes.data();
+	codec::decode(integers2.begin(), integers2.end(), b_it, meta);
+	REQUIRE(integers2 == integers);
+}
+
+TEST_CASE("integer codec selects pagpfr", "[codec]")
+{
+	using codec = oroch::integer_codec<int32_t>;
+	std::vector<int32_t> integers(64 * INTS);
+	std::vector<int32_t> integers2(64 * INTS);
+	for (int i = 0; i < 64 * INTS; i++)
+		integers[i] = (i % INTS) ? (i * 7) % (1 << ((i / INTS) % 6 + 1))
+					 : (1 << 12) + i % 64;
+
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end());
+	REQUIRE(meta.value_desc.encoding == oroch::encoding_t::pagpfr);
+	REQUIRE(codec::has_fetch(meta));
+
+	std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+	oroch::dst_bytes_t d_it = bytes.data();
+	meta.encode(d_it);
+	codec::encode(d_it, integers.begin(), integers.end(), meta);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	codec::metadata meta2;
+	oroch::src_bytes_t b_it = bytes.data();
+	meta2.decode(b_it);
+	REQUIRE(meta2.value_desc.encoding == oroch::encoding_t::pagpfr);
+
+	for (int i = 0; i < 64 * INTS; i += 61)
+		REQUIRE(codec::fetch(b_it, i, meta2) == integers[i]);
+
+	codec::decode(integers2.begin(), integers2.end(), b_it, meta2);
+	for (int i = 0; i < 64 * INTS; i++)
+		REQUIRE(integers2[i] == integers[i]);
+}
+
+TEST_CASE("integer codec selects bitdlt", "[codec]")
+{
+	using codec = oroch::integer_codec<int32_t>;
+	std::vector<int32_t> integers(8 * INTS);
+	std::vector<int32_t> integers2(8 * INTS);
+	// A random walk with steps from -1 to 2. It strays too far from a line
+	// for bitlin.
+	int32_t value = -100;
+	for (int i = 0; i < 8 * INTS; i++) {
+		uint32_t h = uint32_t(i) * 0x9e3779b9;
+		h = (h ^ (h >> 16)) * 0x85ebca6b;
+		h ^= h >> 13;
+		value += int32_t(h >> 30) - 1;
+		integers[i] = value;
+	}
+
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end());
+	REQUIRE(meta.value_desc.encoding == oroch::encoding_t::bitdlt);
+	REQUIRE(meta.value_desc.nbits == 2);
+	REQUIRE(!codec::has_fetch(meta));
+
+	std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+	oroch::dst_bytes_t d_it = bytes.data();
+	meta.encode(d_it);
+	codec::encode(d_it, integers.begin(), integers.end(), meta);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	codec::metadata meta2;
+	oroch::src_bytes_t b_it = bytes.data();
+	meta2.decode(b_it);
+	REQUIRE(meta2.value_desc.encoding == oroch::encoding_t::bitdlt);
+	REQUIRE(meta2.value_desc.origin == -1);
+
+	codec::decode(integers2.begin(), integers2.end(), b_it, meta2);
+	for (int i = 0; i < 8 * INTS; i++)
+		REQUIRE(integers2[i] == integers[i]);
+
+	// Random access rules it out.
+	codec::metadata meta3;
+	codec::select(meta3, integers.begin(), integers.end(), 64);
+	REQUIRE(meta3.value_desc.encoding != oroch::encoding_t::bitdlt);
+}
+
+TEST_CASE("integer codec selects bitdod", "[codec]")
+{
+	using codec = oroch::integer_codec<int64_t>;
+	std::vector<int64_t> integers(8 * INTS);
+	std::vector<int64_t> integers2(8 * INTS);
+	for (int i = 0; i < 8 * INTS; i++)
+		integers[i] = 1500000000000 + i * 1000 + (i % 97 ? 0 : 37);
+
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end());
+	REQUIRE(meta.value_desc.encoding == oroch::encoding_t::bitdod);
+	REQUIRE(!codec::has_fetch(meta));
+	// Well below a byte per value.
+	REQUIRE(meta.dataspace() < integers.size() / 4);
+
+	std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+	oroch::dst_bytes_t d_it = bytes.data();
+	meta.encode(d_it);
+	codec::encode(d_it, integers.begin(), integers.end(), meta);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	codec::metadata meta2;
+	oroch::src_bytes_t b_it = bytes.data();
+	meta2.decode(b_it);
+	REQUIRE(meta2.value_desc.encoding == oroch::encoding_t::bitdod);
+
+	codec::decode(integers2.begin(), integers2.end(), b_it, meta2);
+	for (int i = 0; i < 8 * INTS; i++)
+		REQUIRE(integers2[i] == integers[i]);
+}
+
+TEST_CASE("integer codec selects runlen", "[codec]")
+{
+	using codec = oroch::integer_codec<int32_t>;
+	std::vector<int32_t> integers(8 * INTS);
+	std::vector<int32_t> integers2(8 * INTS);
+	for (int i = 0; i < 8 * INTS; i++)
+		integers[i] = 200 + (i / 50 % 3) * 100 + (i / 150 % 2) * 4;
+
+	for (size_t index_stride : {0, 64}) {
+		codec::metadata meta;
+		codec::select(meta, integers.begin(), integers.end(), index_stride);
+		REQUIRE(meta.value_desc.encoding == oroch::encoding_t::runlen);
+		REQUIRE(meta.nruns == (8 * INTS + 49) / 50);
+		REQUIRE(meta.dataspace() < integers.size() / 8);
+
+		std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+		oroch::dst_bytes_t d_it = bytes.data();
+		meta.encode(d_it);
+		codec::encode(d_it, integers.begin(), integers.end(), meta);
+		REQUIRE(d_it == bytes.data() + bytes.size());
+
+		codec::metadata meta2;
+		oroch::src_bytes_t b_it = bytes.data();
+		meta2.decode(b_it);
+		REQUIRE(meta2.value_desc.encoding == oroch::encoding_t::runlen);
+		REQUIRE(meta2.nruns == meta.nruns);
+
+		const oroch::src_bytes_t data = b_it;
+		codec::decode(integers2.begin(), integers2.end(), b_it, meta2);
+		REQUIRE(b_it == bytes.data() + bytes.size());
+		for (int i = 0; i < 8 * INTS; i++)
+			REQUIRE(integers2[i] == integers[i]);
+
+		// The run ends are sorted so without random access they
+		// might take bitdlt.
+		if (index_stride)
+			REQUIRE(codec::has_fetch(meta2));
+		if (codec::has_fetch(meta2)) {
+			for (int i = 0; i < 8 * INTS; i += 7)
+				REQUIRE(codec::fetch(data, i, meta2) == integers[i]);
+
+			std::vector<int32_t> integers3(8 * INTS - 77);
+			codec::decode_range(
+				integers3.begin(), integers3.end(), data, 77, meta2);
+			for (size_t i = 0; i < integers3.size(); i++)
+				REQUIRE(integers3[i] == integers[i + 77]);
+		}
+
+		int64_t sum = 0;
+		size_t count = 0;
+		for (int32_t value : integers) {
+			sum += value;
+			count += (value >= 300 && value <= 304);
+		}
+		REQUIRE(codec::sum(data, integers.size(), meta2) == sum);
+
+		REQUIRE(codec::has_scan(meta2));
+		REQUIRE(codec::count(data, integers.size(), 300, 304, meta2) == count);
+		std::vector<uint64_t> bitmap(8 * INTS / 64);
+		REQUIRE(codec::scan(bitmap.data(), data, integers.size(), 300, 304, meta2)
+			== count);
+		for (int i = 0; i < 8 * INTS; i++) {
+			const bool bit = (bitmap[i / 64] >> (i % 64)) & 1;
+			REQUIRE(bit == (integers[i] >= 300 && integers[i] <= 304));
+		}
+	}
+
+	// Values that seldom repeat do not make runs.
+	for (int i = 0; i < 8 * INTS; i++)
+		integers[i] = i * 7 % 1000;
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end());
+	REQUIRE(meta.value_desc.encoding != oroch::encoding_t::runlen);
+}
+
+TEST_CASE("integer codec selects bitdic", "[codec]")
+{
+	using codec = oroch::integer_codec<uint64_t>;
+	std::vector<uint64_t> integers(8 * INTS);
+	std::vector<uint64_t> integers2(8 * INTS);
+	for (uint64_t i = 0; i < 8 * INTS; i++) {
+		// A few dozen hashed tenant ids.
+		uint64_t h = i * 0xff51afd7ed558ccd;
+		h ^= h >> 29;
+		integers[i] = (h % 37 + 1) * 0x9e3779b97f4a7c15;
+	}
+
+	for (size_t index_stride : {0, 64}) {
+		codec::metadata meta;
+		codec::select(meta, integers.begin(), integers.end(), index_stride);
+		REQUIRE(meta.value_desc.encoding == oroch::encoding_t::bitdic);
+		REQUIRE(meta.ndistinct == 37);
+		REQUIRE(meta.value_desc.nbits == 6);
+
+		std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+		oroch::dst_bytes_t d_it = bytes.data();
+		meta.encode(d_it);
+		codec::encode(d_it, integers.begin(), integers.end(), meta);
+		REQUIRE(d_it == bytes.data() + bytes.size());
+
+		codec::metadata meta2;
+		oroch::src_bytes_t b_it = bytes.data();
+		meta2.decode(b_it);
+		REQUIRE(meta2.value_desc.encoding == oroch::encoding_t::bitdic);
+		REQUIRE(meta2.ndistinct == meta.ndistinct);
+
+		const oroch::src_bytes_t data = b_it;
+		codec::decode(integers2.begin(), integers2.end(), b_it, meta2);
+		REQUIRE(b_it == bytes.data() + bytes.size());
+		for (int i = 0; i < 8 * INTS; i++)
+			REQUIRE(integers2[i] == integers[i]);
+
+		if (index_stride)
+			REQUIRE(codec::has_fetch(meta2));
+		if (codec::has_fetch(meta2)) {
+			for (int i = 0; i < 8 * INTS; i += 7)
+				REQUIRE(codec::fetch(data, i, meta2) == integers[i]);
+
+			std::vector<uint64_t> integers3(8 * INTS - 77);
+			codec::decode_range(
+				integers3.begin(), integers3.end(), data, 77, meta2);
+			for (size_t i = 0; i < integers3.size(); i++)
+				REQUIRE(integers3[i] == integers[i + 77]);
+		}
+
+		// A lookup is a dictionary probe and a scan of the codes.
+		const uint64_t value = integers[100];
+		size_t count = 0;
+		for (uint64_t v : integers)
+			count += (v == value);
+		REQUIRE(codec::has_scan(meta2));
+		REQUIRE(codec::count(data, integers.size(), value, value, meta2) == count);
+		std::vector<uint64_t> bitmap(8 * INTS / 64);
+		REQUIRE(codec::scan(bitmap.data(), data, integers.size(), value, value, meta2)
+			== count);
+		for (int i = 0; i < 8 * INTS; i++) {
+			const bool bit = (bitmap[i / 64] >> (i % 64)) & 1;
+			REQUIRE(bit == (integers[i] == value));
+		}
+	}
+
+	// Too many distinct values.
+	for (uint64_t i = 0; i < 8 * INTS; i++)
+		integers[i] = (i * 7 % 1000) * 0x9e3779b97f4a7c15;
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end());
+	REQUIRE(meta.value_desc.encoding != oroch::encoding_t::bitdic);
+}
+
+TEST_CASE("integer codec selects bitlin", "[codec]")
+{
+	using codec = oroch::integer_codec<int64_t>;
+	std::vector<int64_t> integers(8 * INTS);
+	std::vector<int64_t> integers2(8 * INTS);
+	for (int i = 0; i < 8 * INTS; i++)
+		integers[i] = 1000000 + i * 4096 + (i * 7) % 5;
+
+	// It provides random access so the skip index changes nothing.
+	for (size_t index_stride : {0, 64}) {
+		codec::metadata meta;
+		codec::select(meta, integers.begin(), integers.end(), index_stride);
+		REQUIRE(meta.value_desc.encoding == oroch::encoding_t::bitlin);
+		REQUIRE(meta.value_desc.slope == 4096);
+		REQUIRE(meta.value_desc.nbits == 3);
+
+		std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+		oroch::dst_bytes_t d_it = bytes.data();
+		meta.encode(d_it);
+		codec::encode(d_it, integers.begin(), integers.end(), meta);
+		REQUIRE(d_it == bytes.data() + bytes.size());
+
+		codec::metadata meta2;
+		oroch::src_bytes_t b_it = bytes.data();
+		meta2.decode(b_it);
+		REQUIRE(meta2.value_desc.encoding == oroch::encoding_t::bitlin);
+		REQUIRE(meta2.value_desc.slope == 4096);
+
+		const oroch::src_bytes_t data = b_it;
+		codec::decode(integers2.begin(), integers2.end(), b_it, meta2);
+		REQUIRE(b_it == bytes.data() + bytes.size());
+		for (int i = 0; i < 8 * INTS; i++)
+			REQUIRE(integers2[i] == integers[i]);
+
+		REQUIRE(codec::has_fetch(meta2));
+		for (int i = 0; i < 8 * INTS; i += 7)
+			REQUIRE(codec::fetch(data, i, meta2) == integers[i]);
+
+		std::vector<int64_t> integers3(8 * INTS - 77);
+		codec::decode_range(integers3.begin(), integers3.end(), data, 77, meta2);
+		for (size_t i = 0; i < integers3.size(); i++)
+			REQUIRE(integers3[i] == integers[i + 77]);
+	}
+
+	// An exact progression takes no data at all.
+	for (int i = 0; i < 8 * INTS; i++)
+		integers[i] = i - 100;
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end(), 64);
+	REQUIRE(meta.value_desc.encoding == oroch::encoding_t::bitlin);
+	REQUIRE(meta.dataspace() == 0);
+}
+
+TEST_CASE("integer codec bitpfr with scratch", "[codec]")
+{
+	using codec = oroch::integer_codec<int32_t>;
+	codec::scratch outliers;
+
+	for (int step : {7, 3, 11}) {
+		std::array<int32_t, 4 * INTS> integers;
+		std::array<int32_t, 4 * INTS> integers2;
+		for (int i = 0; i < 4 * INTS; i++)
+			integers[i] = (i % step) ? 1 + i % 4 : i * i * 100;
+
+		codec::metadata meta;
+		codec::select(meta, integers.begin(), integers.end());
+		REQUIRE(meta.value_desc.encoding == oroch::encoding_t::bitpfr);
+
+		std::vector<uint8_t> bytes(meta.dataspace());
+		oroch::dst_bytes_t d_it = bytes.data();
+		codec::encode(d_it, integers.begin(), integers.end(), meta, outliers);
+		REQUIRE(d_it == bytes.data() + bytes.size());
+		REQUIRE(outliers.values.size() == meta.noutliers);
+
+		oroch::src_bytes_t b_it = bytes.data();
+		codec::decode(integers2.begin(), integers2.end(), b_it, meta, outliers);
+		for (int i = 0; i < 4 * INTS; i++)
+			REQUIRE(integers2[i] == integers[i]);
+	}
+}
+
+TEST_CASE("integer codec sampled selection", "[codec]")
+{
+	using codec = oroch::integer_codec<int32_t>;
+	const int n = 256 * INTS;
+	std::vector<int32_t> integers(n);
+	std::vector<int32_t> integers2(n);
+
+	// Small values with rare huge ones mostly missed by the sample.
+	for (int i = 0; i < n; i++)
+		integers[i] = (i % 1000 == 999) ? (1 << 28) + i : (i * 13) % 200;
+	// Byte-aligned friendly values with a single huge one out of sample.
+	std::vector<int32_t> varints(n);
+	for (int i = 0; i < n; i++)
+		varints[i] = (i % 2) ? 100 + i % 100 : 20000 + i % 10000;
+	varints[n / 2 + 300] = -(1 << 30);
+	// Long runs that are only sized on the whole sequence if the sample
+	// picks them.
+	std::vector<int32_t> runs(n);
+	for (int i = 0; i < n; i++)
+		runs[i] = (i / 500 % 7) * 1000 + 5;
+
+	// A line that the sample shows only at the right positions.
+	std::vector<int32_t> line(n);
+	for (int i = 0; i < n; i++)
+		line[i] = 3 * i + (i * 37) % 5;
+
+	for (auto *values : {&integers, &varints, &runs, &line}) {
+		const auto minmax = std::minmax_element(values->begin(), values->end());
+		const uint32_t range = uint32_t(*minmax.second) - uint32_t(*minmax.first);
+		for (size_t stride : {2, 4, 16}) {
+			codec::metadata meta;
+			codec::select_sampled(meta, values->begin(), values->end(), stride);
+			INFO("encoding: " << (int) meta.value_desc.encoding
+					  << ", stride: " << stride);
+
+			// The range comes from the whole sequence even if the
+			// extremes are out of the sample.
+			switch (meta.value_desc.encoding) {
+			case oroch::encoding_t::bitfor:
+			case oroch::encoding_t::bitvec:
+			case oroch::encoding_t::bitstr:
+			case oroch::encoding_t::optpfd:
+			case oroch::encoding_t::pagpfr:
+				REQUIRE(meta.value_desc.origin == *minmax.first);
+				REQUIRE(meta.value_desc.nbits
+					== size_t(oroch::integer_traits<uint32_t>::usedcount(range)));
+				break;
+			default:
+				break;
+			}
+			if (values == &runs)
+				REQUIRE(meta.value_desc.encoding == oroch::encoding_t::runlen);
+			if (values == &line)
+				REQUIRE(meta.value_desc.encoding == oroch::encoding_t::bitlin);
+
+			std::vector<uint8_t> bytes(meta.metaspace() + meta.dataspace());
+			oroch::dst_bytes_t d_it = bytes.data();
+			meta.encode(d_it);
+			codec::encode(d_it, values->begin(), values->end(), meta);
+			REQUIRE(d_it == bytes.data() + bytes.size());
+
+			codec::metadata meta2;
+			oroch::src_bytes_t b_it = bytes.data();
+			meta2.decode(b_it);
+			codec::decode(integers2.begin(), integers2.end(), b_it, meta2);
+			for (int i = 0; i < n; i++)
+				REQUIRE(integers2[i] == (*values)[i]);
+		}
+	}
+}
+
+TEST_CASE("integer codec cost policy", "[codec]")
+{
+	using codec = oroch::integer_codec<uint32_t>;
+	std::array<uint32_t, 4 * INTS> integers;
+	for (int i = 0; i < 4 * INTS; i++)
+		integers[i] = (i % 16) ? i % 100 : 1000 + i;
+
+	// The patched bits are smallest and stay ahead when balanced but
+	// plain vertical bits decode fastest.
+	codec::metadata small, balanced, fast, slow;
+	codec::select(small, integers.begin(), integers.end());
+	codec::select(balanced, integers.begin(), integers.end(), 0,
+		      oroch::encoding_cost::balanced());
+	codec::select(fast, integers.begin(), integers.end(), 0,
+		      oroch::encoding_cost::max_speed());
+	REQUIRE(small.value_desc.encoding == oroch::encoding_t::bitpfr);
+	REQUIRE(balanced.value_desc.encoding == oroch::encoding_t::bitpfr);
+	REQUIRE(fast.value_desc.encoding == oroch::encoding_t::bitvec);
+	REQUIRE(small.dataspace() + small.metaspace() <= fast.dataspace() + fast.metaspace());
+
+	// Make the selected encoding look very slow so that another one wins.
+	oroch::encoding_cost cost = oroch::encoding_cost::balanced();
+	cost.decode_cost(small.value_desc.encoding, 1000);
+	codec::select(slow, integers.begin(), integers.end(), 0, cost);
+	REQUIRE(slow.value_desc.encoding != small.value_desc.encoding);
+
+	// Disable all but one encoding.
+	oroch::encoding_cost only;
+	for (size_t e = 0; e < oroch::encoding_count; e++)
+		only.disable(static_cast<oroch::encoding_t>(e));
+	REQUIRE(only.enabled(oroch::encoding_t::normal));
+	only.enable(oroch::encoding_t::varint);
+	codec::metadata meta;
+	codec::select(meta, integers.begin(), integers.end(), 0, only);
+	REQUIRE(meta.value_desc.encoding == oroch::encoding_t::varint);
+
+	// A noisy line is smallest relative to the line, a little larger
+	// but faster to decode as differences and fastest as plain bits.
+	std::array<uint32_t, 8 * INTS> line;
+	for (uint32_t i = 0; i < 8 * INTS; i++)
+		line[i] = i * 5 + (i * 2654435761u >> 30);
+	codec::metadata line_small, line_balanced, line_fast;
+	codec::select(line_small, line.begin(), line.end());
+	codec::select(line_balanced, line.begin(), line.end(), 0,
+		      oroch::encoding_cost::balanced());
+	codec::select(line_fast, line.begin(), line.end(), 0,
+		      oroch::encoding_cost::max_speed());
+	REQUIRE(line_small.value_desc.encoding == oroch::encoding_t::bitlin);
+	REQUIRE(line_balanced.value_desc.encoding == oroch::encoding_t::bitdlt);
+	REQUIRE(line_fast.value_desc.encoding == oroch::encoding_t::bitvec);
+
+	// A disabled encoding is never selected. The naught and normal ones
+	// are always available.
+	for (size_t e = 2; e < oroch::encoding_count; e++) {
+		for (double weight : {0.0, 0.5, 64.0}) {
+			oroch::encoding_cost without(weight);
+			without.disable(static_cast<oroch::encoding_t>(e));
+			codec::metadata meta3;
+			codec::select(meta3, line.begin(), line.end(), 0, without);
+			REQUIRE(meta3.value_desc.encoding != e);
+			codec::select(meta3, integers.begin(), integers.end(), 0, without);
+			REQUIRE(meta3.value_desc.encoding != e);
+		}
+	}
+
+	// Calibrate and round-trip with the measured figures.
+	oroch::encoding_cost calibrated = oroch::encoding_cost::balanced();
+	codec::calibrate(calibrated, 1024, 2);
+	for (size_t e = 0; e < oroch::encoding_count; e++) {
+		double time = calibrated.decode_cost(static_cast<oroch::encoding_t>(e));
+		REQUIRE(time >= 0);
+		REQUIRE(time < 1e6);
+	}
+	codec::metadata meta2;
+	codec::select(meta2, integers.begin(), integers.end(), 0, calibrated);
+
+	std::vector<uint8_t> bytes(meta2.dataspace());
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), meta2);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	std::array<uint32_t, 4 * INTS> integers2;
+	oroch::src_bytes_t b_it = bytes.data();
+	codec::decode(integers2.begin(), integers2.end(), b_it, meta2);
+	for (int i = 0; i < 4 * INTS; i++)
+		REQUIRE(integers2[i] == integers[i]);
+}
@@ -1,6 +1,8 @@
 #include "catch.hpp"
 
 #include <array>
+#include <vector>
+
 #include <oroch/integer_group.h>
 
 #define INTS 8
@@ -20,3 +22,52 @@ TEST_CASE("integer group", "[group]")
 			REQUIRE(integers2[i] == integers[i]);
 	}
 }
+
+TEST_CASE("integer group decode range", "[group]")
+{
+	oroch::integer_group<int32_t> group;
+	std::vector<int32_t> integers(1000);
+
+	// Data for different encodings with random access.
+	for (int kind = 0; kind < 4; kind++) {
+		for (size_t i = 0; i < integers.size(); i++) {
+			switch (kind) {
+			case 0: // bit-packing
+				integers[i] = 1000 + i % 77;
+				break;
+			case 1: // varint
+				integers[i] = (i % 7) ? 1 : int32_t(i * i * 100);
+				break;
+			case 2: // normal
+				integers[i] = int32_t(i * 0x9e3779b9u);
+				break;
+			case 3: // naught
+				integers[i] = 5;
+				break;
+			}
+		}
+
+		for (size_t stride : {0, 16}) {
+			group.encode(integers.begin(), integers.end(), true, stride);
+
+			oroch::integer_group<int32_t>::codec::metadata meta;
+			group.decode(meta);
+			if (!oroch::integer_group<int32_t>::codec::has_fetch(meta)) {
+				std::vector<int32_t> values(10);
+				REQUIRE_THROWS_AS(group.decode_range(10, 20, values.begin()),
+						  std::logic_error);
+				continue;
+			}
+
+			for (size_t first : {0, 1, 17, 200, 640, 999}) {
+				for (size_t count : {0, 1, 31, 300}) {
+					size_t last = std::min(first + count, integers.size());
+					std::vector<int32_t> values(last - first);
+					group.decode_range(first, last, values.begin());
+					for (size_t i = first; i < last; i++)
+						REQUIRE(values[i - first] == integers[i]);
+				}
+			}
+		}
+	}
+}
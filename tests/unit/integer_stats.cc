@@ -0,0 +1,129 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <vector>
+
+#include <oroch/integer_stats.h>
+#include <oroch/offset.h>
+
+TEST_CASE("integer stats outlier index", "[stats]")
+{
+	using traits = oroch::integer_traits<uint64_t>;
+
+	std::vector<int64_t> integers;
+	for (uint64_t i = 0; i < 1000; i++) {
+		const uint64_t x = i * 0x9e3779b97f4a7c15;
+		integers.push_back(int64_t(x >> (x % 64)) >> (i % 3 ? 40 : 0));
+	}
+
+	oroch::integer_stats<int64_t> stats(integers.begin(), integers.end());
+	stats.build_outlier_index(integers.begin(), integers.end());
+
+	for (size_t nbits = 0; nbits < 64; nbits++) {
+		size_t space = 0, gap_nbits = 0;
+		oroch::offset_codec<size_t, 1, false> index_codec(0);
+		for (size_t i = 0; i < integers.size(); i++) {
+			const size_t width = traits::usedcount(integers[i] - stats.min());
+			if (width <= nbits)
+				continue;
+			const size_t gap = index_codec.value_encode(i);
+			space += oroch::varint_codec<size_t>::value_space(gap);
+			if (gap_nbits < size_t(traits::usedcount(gap)))
+				gap_nbits = traits::usedcount(gap);
+		}
+		REQUIRE(stats.outlier_index_space(nbits) == space);
+		REQUIRE(stats.outlier_index_nbits(nbits) == gap_nbits);
+	}
+}
+
+template <typename T>
+static void
+check_stats(size_t n)
+{
+	using traits = oroch::integer_traits<T>;
+	using unsigned_t = typename traits::unsigned_t;
+
+	std::vector<T> integers;
+	std::list<T> list;
+	for (uint64_t i = 0; i < n; i++) {
+		const uint64_t x = (i + 1) * 0x9e3779b97f4a7c15;
+		integers.push_back(T(x >> (x % 64)));
+		list.push_back(integers.back());
+	}
+
+	// The vector iterators go the contiguous way, the list ones do not.
+	oroch::integer_stats<T> stats(integers.begin(), integers.end());
+	oroch::integer_stats<T> scalar(list.begin(), list.end());
+	REQUIRE(stats.nvalues() == n);
+	REQUIRE(stats.min() == scalar.min());
+	REQUIRE(stats.max() == scalar.max());
+
+	// The differences wrap around and are taken as signed.
+	using signed_t = typename traits::signed_t;
+	signed_t dmin = std::numeric_limits<signed_t>::max();
+	signed_t dmax = std::numeric_limits<signed_t>::min();
+	for (size_t i = 1; i < n; i++) {
+		const unsigned_t u = unsigned_t(integers[i]) - unsigned_t(integers[i - 1]);
+		const signed_t d = signed_t(u);
+		dmin = std::min(dmin, d);
+		dmax = std::max(dmax, d);
+	}
+	REQUIRE(stats.delta_min() == dmin);
+	REQUIRE(stats.delta_max() == dmax);
+	REQUIRE(scalar.delta_min() == dmin);
+	REQUIRE(scalar.delta_max() == dmax);
+
+	// Make some runs.
+	std::vector<T> runs;
+	for (size_t i = 0; i < n; i++)
+		runs.push_back(integers[i / 5 * 5 % 3 ? i / 5 * 5 : i]);
+	size_t nruns = 0;
+	for (size_t i = 0; i < n; i++)
+		nruns += i == 0 || runs[i] != runs[i - 1];
+	std::list<T> runs_list(runs.begin(), runs.end());
+	REQUIRE(oroch::integer_stats<T>(runs.begin(), runs.end()).nruns() == nruns);
+	REQUIRE(oroch::integer_stats<T>(runs_list.begin(), runs_list.end()).nruns() == nruns);
+
+	stats.build_histogram(integers.data(), integers.data() + n);
+	scalar.build_histogram(list.begin(), list.end());
+	for (size_t k = 0; k <= traits::nbits; k++) {
+		REQUIRE(stats.histogram(k) == scalar.histogram(k));
+		REQUIRE(stats.zigzag_histogram(k) == scalar.zigzag_histogram(k));
+	}
+
+	// The zigzag histogram does not depend on the minimum.
+	std::vector<size_t> zigzag(traits::nbits + 1);
+	for (T value : integers)
+		zigzag[traits::usedcount(oroch::zigzag_codec<T>::encode_if_signed(value))]++;
+	for (size_t k = 0; k <= traits::nbits; k++)
+		REQUIRE(stats.zigzag_histogram(k) == zigzag[k]);
+
+	// Every width boundary is counted right.
+	std::vector<T> edges(1, std::numeric_limits<T>::min());
+	for (size_t k = 0; k < traits::nbits; k++) {
+		const unsigned_t bit = unsigned_t(1) << k;
+		edges.push_back(T(edges[0] + T(bit)));
+		edges.push_back(T(edges[0] + T(bit | (bit - 1))));
+	}
+	oroch::integer_stats<T> estats(edges.begin(), edges.end());
+	estats.build_histogram(edges.begin(), edges.end());
+	REQUIRE(estats.histogram(0) == 1);
+	for (size_t k = 1; k <= traits::nbits; k++)
+		REQUIRE(estats.histogram(k) == 2);
+}
+
+TEST_CASE("integer stats vector kernels", "[stats]")
+{
+	for (size_t n : {0, 1, 7, 31, 33, 100, 1000}) {
+		check_stats<int8_t>(n);
+		check_stats<uint8_t>(n);
+		check_stats<int16_t>(n);
+		check_stats<uint16_t>(n);
+		check_stats<int32_t>(n);
+		check_stats<uint32_t>(n);
+		check_stats<int64_t>(n);
+		check_stats<uint64_t>(n);
+	}
+}
@@ -0,0 +1,61 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <vector>
+
+#include <oroch/optpfd.h>
+#include <oroch/origin.h>
+
+TEST_CASE("optpfd codec layout", "[optpfd]")
+{
+	using codec = oroch::optpfd_codec<uint32_t>;
+
+	// A single exception with 9 high bits.
+	std::vector<uint32_t> integers(128, 1);
+	integers[3] = 0x3ff;
+
+	std::vector<uint8_t> bytes(codec::space(integers.begin(), integers.end(), 10));
+	REQUIRE(bytes.size() == 2 + 1 + 2 + 16);
+
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), 10);
+	REQUIRE(bytes[0] == 1);
+	REQUIRE(bytes[1] == 1);
+	REQUIRE(bytes[2] == 3);
+	REQUIRE(bytes[3] == 0xff);
+	REQUIRE(bytes[4] == 0x01);
+	REQUIRE(bytes[5] == 0xff);
+
+	check_codec<codec>(integers, bytes.size(), 10);
+}
+
+TEST_CASE("optpfd codec for all widths", "[optpfd]")
+{
+	for (size_t nbits = 1; nbits <= 64; nbits++) {
+		const uint64_t mask = uint64_t(-1) >> (64 - nbits);
+		std::vector<uint64_t> integers;
+		for (uint64_t i = 0; i < 300; i++) {
+			uint64_t x = i * 0x9e3779b97f4a7c15;
+			integers.push_back((i % 13) ? x % 7 & mask : x & mask);
+		}
+		integers[5] = mask;
+		using codec = oroch::optpfd_codec<uint64_t>;
+		const size_t space = codec::space(integers.begin(), integers.end(), nbits);
+		const auto bytes = check_codec<codec>(integers, space, nbits);
+		check_fetch<codec>(integers, bytes, nbits);
+		check_decode_range<codec>(integers, bytes, {1, 130, 250}, nbits);
+	}
+}
+
+TEST_CASE("optpfd codec with frame of reference", "[optpfd]")
+{
+	std::vector<int32_t> integers;
+	for (int32_t i = 0; i < 260; i++)
+		integers.push_back((i % 10) ? -1000 + i % 4 : i * i * 100);
+	using codec = oroch::optpfd_codec<int32_t, oroch::origin_codec<int32_t>>;
+	const oroch::origin_codec<int32_t> vcodec(-1000);
+	const size_t space = codec::space(integers.begin(), integers.end(), 23, vcodec);
+	const auto bytes = check_codec<codec>(integers, space, 23, vcodec);
+	check_fetch<codec>(integers, bytes, 23, vcodec);
+	check_decode_range<codec>(integers, bytes, {1, 130, 250}, 23, vcodec);
+}
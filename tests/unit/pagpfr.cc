@@ -0,0 +1,84 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <oroch/optpfd.h>
+#include <oroch/origin.h>
+#include <oroch/pagpfr.h>
+
+TEST_CASE("pagpfr codec layout", "[pagpfr]")
+{
+	using codec = oroch::pagpfr_codec<uint32_t>;
+
+	// A zero group and a group with a single exception with 9 high bits.
+	std::vector<uint32_t> integers(256, 0);
+	for (size_t i = 128; i < 256; i++)
+		integers[i] = 1;
+	integers[131] = 0x3ff;
+
+	std::vector<uint8_t> bytes(codec::space(integers.begin(), integers.end(), 10));
+	REQUIRE(bytes.size() == (1 + 2 + 8) + 2 + (2 + 1 + 16));
+
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), 10);
+	REQUIRE(bytes[0] == 1);
+	REQUIRE(bytes[1] == 9);
+	REQUIRE(bytes[2] == 1);
+	REQUIRE(bytes[3] == 0xff);
+	REQUIRE(bytes[4] == 0x01);
+	REQUIRE(bytes[11] == 0);
+	REQUIRE(bytes[12] == 0);
+	REQUIRE(bytes[13] == 1);
+	REQUIRE(bytes[14] == 1);
+	REQUIRE(bytes[15] == 3);
+
+	const auto bytes2 = check_codec<codec>(integers, bytes.size(), 10);
+	check_decode_range<codec>(integers, bytes2, {1, 130}, 10);
+}
+
+TEST_CASE("pagpfr codec for all widths", "[pagpfr]")
+{
+	for (size_t nbits = 1; nbits <= 64; nbits++) {
+		const uint64_t mask = uint64_t(-1) >> (64 - nbits);
+		std::vector<uint64_t> integers;
+		for (uint64_t i = 0; i < 700; i++) {
+			uint64_t x = i * 0x9e3779b97f4a7c15;
+			integers.push_back((i % 13) ? x % 7 & mask : x & mask);
+		}
+		integers[5] = mask;
+		using codec = oroch::pagpfr_codec<uint64_t>;
+		const size_t space = codec::space(integers.begin(), integers.end(), nbits);
+		const auto bytes = check_codec<codec>(integers, space, nbits);
+		check_fetch<codec>(integers, bytes, nbits);
+		check_decode_range<codec>(integers, bytes, {1, 130, 250, 600}, nbits);
+	}
+}
+
+TEST_CASE("pagpfr codec pools exceptions", "[pagpfr]")
+{
+	std::vector<int32_t> integers;
+	for (int32_t i = 0; i < 1000; i++)
+		integers.push_back((i % 50) ? -1000 + i % 4 : i * i * 100);
+
+	using codec = oroch::pagpfr_codec<int32_t, oroch::origin_codec<int32_t>>;
+	const oroch::origin_codec<int32_t> vcodec(-1000);
+	const size_t space = codec::space(integers.begin(), integers.end(), 27, vcodec);
+	const auto bytes = check_codec<codec>(integers, space, 27, vcodec);
+	check_fetch<codec>(integers, bytes, 27, vcodec);
+	check_decode_range<codec>(integers, bytes, {1, 130, 250, 600}, 27, vcodec);
+
+	// Encoding the groups one by one takes more space.
+	size_t group_space = 0;
+	for (size_t i = 0; i < integers.size(); i += codec::group_capacity) {
+		const size_t n = std::min(integers.size() - i, codec::group_capacity);
+		group_space += codec::space(
+			integers.begin() + i, integers.begin() + i + n, 27, vcodec);
+	}
+	REQUIRE(space < group_space);
+
+	// The exception high bits are not rounded up for every group.
+	using optpfd = oroch::optpfd_codec<int32_t, oroch::origin_codec<int32_t>>;
+	REQUIRE(space < optpfd::space(integers.begin(), integers.end(), 27, vcodec));
+}
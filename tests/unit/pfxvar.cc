@@ -0,0 +1,116 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <array>
+#include <vector>
+
+#include <oroch/origin.h>
+#include <oroch/pfxvar.h>
+
+using pfxvar32 = oroch::pfxvar_codec<uint32_t>;
+using pfxvar64 = oroch::pfxvar_codec<uint64_t>;
+
+TEST_CASE("pfxvar codec space calculation", "[pfxvar]")
+{
+	REQUIRE(pfxvar64::value_space(0) == 1);
+	REQUIRE(pfxvar64::value_space(1) == 1);
+	REQUIRE(pfxvar64::value_space(127) == 1);
+	REQUIRE(pfxvar64::value_space(128) == 2);
+	REQUIRE(pfxvar64::value_space(16383) == 2);
+	REQUIRE(pfxvar64::value_space(16384) == 3);
+	REQUIRE(pfxvar64::value_space((uint64_t(1) << 56) - 1) == 8);
+	REQUIRE(pfxvar64::value_space(uint64_t(1) << 56) == 9);
+	REQUIRE(pfxvar64::value_space(UINT64_MAX) == 9);
+	REQUIRE(pfxvar32::value_space(UINT32_MAX) == 5);
+}
+
+TEST_CASE("pfxvar codec for single value", "[pfxvar]")
+{
+	std::array<uint8_t, 16> bytes;
+
+	auto it = bytes.begin();
+	pfxvar32::value_encode(it, 1);
+	REQUIRE(it == bytes.begin() + 1);
+	REQUIRE(bytes[0] == 3);
+
+	it = bytes.begin();
+	pfxvar32::value_encode(it, 127);
+	REQUIRE(it == bytes.begin() + 1);
+	REQUIRE(bytes[0] == 255);
+
+	it = bytes.begin();
+	pfxvar32::value_encode(it, 128);
+	REQUIRE(it == bytes.begin() + 2);
+	REQUIRE(bytes[0] == 2);
+	REQUIRE(bytes[1] == 2);
+
+	it = bytes.begin();
+	pfxvar64::value_encode(it, UINT64_MAX);
+	REQUIRE(it == bytes.begin() + 9);
+	REQUIRE(bytes[0] == 0);
+	REQUIRE(bytes[1] == 255);
+
+	for (uint32_t i = 1; i != 0; i += i) {
+		oroch::dst_bytes_t d_it = bytes.begin();
+		pfxvar32::value_encode(d_it, i);
+
+		uint32_t j;
+		oroch::src_bytes_t b_it = bytes.begin();
+		pfxvar32::value_decode(j, b_it);
+		REQUIRE(i == j);
+		REQUIRE(b_it == d_it);
+
+		b_it = bytes.begin();
+		REQUIRE(pfxvar32::unsafe_value_decode(b_it) == i);
+		REQUIRE(b_it == d_it);
+	}
+
+	for (uint64_t i = 1; i != 0; i += i) {
+		oroch::dst_bytes_t d_it = bytes.begin();
+		pfxvar64::value_encode(d_it, i);
+
+		uint64_t j;
+		oroch::src_bytes_t b_it = bytes.begin();
+		pfxvar64::value_decode(j, b_it);
+		REQUIRE(i == j);
+		REQUIRE(b_it == d_it);
+
+		b_it = bytes.begin();
+		REQUIRE(pfxvar64::unsafe_value_decode(b_it) == i);
+		REQUIRE(b_it == d_it);
+	}
+}
+
+TEST_CASE("pfxvar codec for different types", "[pfxvar]")
+{
+	for (size_t n : {0, 1, 7, 8, 9, 100, 1000}) {
+		const auto u8 = random_integers<uint8_t>(n);
+		const auto u16 = random_integers<uint16_t>(n);
+		const auto u32 = random_integers<uint32_t>(n);
+		const auto u64 = random_integers<uint64_t>(n);
+		const auto s16 = random_integers<int16_t>(n);
+		const auto s32 = random_integers<int32_t>(n);
+		const auto s64 = random_integers<int64_t>(n);
+
+		using codec_u8 = oroch::pfxvar_codec<uint8_t>;
+		using codec_u16 = oroch::pfxvar_codec<uint16_t>;
+		using codec_s16 = oroch::pfxvar_codec<int16_t>;
+		using codec_s32 = oroch::pfxvar_codec<int32_t>;
+		using codec_s64 = oroch::pfxvar_codec<int64_t>;
+		check_codec<codec_u8>(u8, codec_u8::space(u8.begin(), u8.end()));
+		check_codec<codec_u16>(u16, codec_u16::space(u16.begin(), u16.end()));
+		check_codec<pfxvar32>(u32, pfxvar32::space(u32.begin(), u32.end()));
+		check_codec<pfxvar64>(u64, pfxvar64::space(u64.begin(), u64.end()));
+		check_codec<codec_s16>(s16, codec_s16::space(s16.begin(), s16.end()));
+		check_codec<codec_s32>(s32, codec_s32::space(s32.begin(), s32.end()));
+		check_codec<codec_s64>(s64, codec_s64::space(s64.begin(), s64.end()));
+	}
+
+	using codec = oroch::pfxvar_codec<uint64_t, oroch::origin_codec<uint64_t>>;
+	const oroch::origin_codec<uint64_t> vcodec(uint64_t(1) << 60);
+	std::vector<uint64_t> integers(100);
+	for (size_t i = 0; i < integers.size(); i++)
+		integers[i] = (uint64_t(1) << 60) + i * i * i;
+	const size_t space = codec::space(integers.begin(), integers.end(), vcodec);
+	check_codec<codec>(integers, space, vcodec);
+}
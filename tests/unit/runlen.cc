@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include <utility>
+#include <vector>
+
+#include <oroch/runlen.h>
+
+using codec = oroch::runlen_codec<int32_t>;
+
+static std::vector<int32_t>
+make_runs()
+{
+	// Runs of lengths 1, 2, 3, ... with values alternating in sign.
+	std::vector<int32_t> integers;
+	for (int32_t run = 0; run < 20; run++) {
+		for (int32_t i = 0; i <= run; i++)
+			integers.push_back(run % 2 ? -run : run % 5);
+	}
+	return integers;
+}
+
+TEST_CASE("runlen codec split", "[runlen]")
+{
+	codec::runs r;
+	std::vector<int32_t> integers{{7, 7, 7, 3, 7, 7, -1}};
+	codec::split(r, integers.begin(), integers.end());
+	REQUIRE(r.size() == 4);
+	REQUIRE(r.values == std::vector<int32_t>({7, 3, 7, -1}));
+	REQUIRE(r.ends == std::vector<size_t>({3, 4, 6, 7}));
+	REQUIRE(r.start(0) == 0);
+	REQUIRE(r.start(2) == 4);
+
+	codec::split(r, integers.end(), integers.end());
+	REQUIRE(r.size() == 0);
+}
+
+TEST_CASE("runlen codec fill", "[runlen]")
+{
+	const std::vector<int32_t> integers = make_runs();
+	codec::runs r;
+	codec::split(r, integers.begin(), integers.end());
+
+	std::vector<int32_t> integers2(integers.size());
+	codec::fill(integers2.begin(), integers2.end(), r);
+	REQUIRE(integers2 == integers);
+
+	for (size_t first : {1, 2, 3, 5, 100, 209}) {
+		std::vector<int32_t> integers3(integers.size() - first);
+		codec::fill(integers3.begin(), integers3.end(), r, first);
+		for (size_t i = 0; i < integers3.size(); i++)
+			REQUIRE(integers3[i] == integers[i + first]);
+	}
+
+	// A range that ends within a run.
+	std::vector<int32_t> integers4(10);
+	codec::fill(integers4.begin(), integers4.end(), r, 4);
+	for (size_t i = 0; i < integers4.size(); i++)
+		REQUIRE(integers4[i] == integers[i + 4]);
+}
+
+TEST_CASE("runlen codec queries", "[runlen]")
+{
+	const std::vector<int32_t> integers = make_runs();
+	codec::runs r;
+	codec::split(r, integers.begin(), integers.end());
+
+	for (int32_t value : {-19, -3, 0, 2, 4, 5, 100}) {
+		size_t position = 0;
+		while (position < integers.size() && integers[position] != value)
+			position++;
+		REQUIRE(codec::find(r, value) == position);
+	}
+
+	int64_t sum = 0;
+	for (int32_t value : integers)
+		sum += value;
+	REQUIRE(codec::sum<int64_t>(r) == sum);
+
+	const std::vector<std::pair<int32_t, int32_t>> ranges{{{-5, 2}, {0, 0}, {6, 9}}};
+	for (auto range : ranges) {
+		std::vector<uint64_t> bitmap((integers.size() + 63) / 64, ~uint64_t(0));
+		size_t count = 0;
+		for (int32_t value : integers)
+			count += (range.first <= value && value <= range.second);
+		REQUIRE(codec::count(r, range.first, range.second) == count);
+		const size_t found = codec::scan(
+			bitmap.data(), r, integers.size(), range.first, range.second);
+		REQUIRE(found == count);
+		for (size_t i = 0; i < integers.size(); i++) {
+			const bool bit = (bitmap[i / 64] >> (i % 64)) & 1;
+			const int32_t value = integers[i];
+			REQUIRE(bit == (range.first <= value && value <= range.second));
+		}
+	}
+}
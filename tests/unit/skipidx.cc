@@ -0,0 +1,61 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include <oroch/pfxvar.h>
+#include <oroch/skipidx.h>
+#include <oroch/varint.h>
+
+#define INTS 1000
+#define STRIDE 32
+
+template <typename C>
+static void
+check_skipidx()
+{
+	using codec = oroch::skipidx_codec<C>;
+	using original_t = typename codec::original_t;
+
+	std::vector<original_t> integers(INTS);
+	for (size_t i = 0; i < INTS; i++)
+		integers[i] = original_t(i * i * (i % 2 ? 1 : -1));
+
+	std::vector<uint8_t> bytes(codec::space(integers.begin(), integers.end(), STRIDE));
+	REQUIRE(bytes.size()
+		== (codec::index_space(INTS, STRIDE)
+		    + C::space(integers.begin(), integers.end())));
+
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), STRIDE);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	std::vector<original_t> integers2(INTS);
+	oroch::src_bytes_t b_it = bytes.data();
+	codec::decode(integers2.begin(), integers2.end(), b_it);
+	REQUIRE(b_it == bytes.data() + bytes.size());
+	for (size_t i = 0; i < INTS; i++)
+		REQUIRE(integers2[i] == integers[i]);
+
+	for (size_t i = 0; i < INTS; i++)
+		REQUIRE(codec::fetch(bytes.data(), i, STRIDE) == integers[i]);
+
+	for (size_t first : {0, 1, 31, 32, 33, 500, 999}) {
+		size_t last = std::min<size_t>(first + 100, INTS);
+		std::vector<original_t> range(last - first);
+		codec::decode_range(range.begin(), range.end(), bytes.data(), first, STRIDE);
+		for (size_t i = first; i < last; i++)
+			REQUIRE(range[i - first] == integers[i]);
+	}
+}
+
+TEST_CASE("skipidx codec for varint", "[skipidx]")
+{
+	check_skipidx<oroch::varint_codec<uint32_t>>();
+	check_skipidx<oroch::varint_codec<int64_t>>();
+}
+
+TEST_CASE("skipidx codec for pfxvar", "[skipidx]")
+{
+	check_skipidx<oroch::pfxvar_codec<uint32_t>>();
+	check_skipidx<oroch::pfxvar_codec<int64_t>>();
+}
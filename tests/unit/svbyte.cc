@@ -0,0 +1,84 @@
+#include "catch.hpp"
+#include "codec_check.h"
+
+#include <array>
+#include <vector>
+
+#include <oroch/origin.h>
+#include <oroch/svbyte.h>
+
+using svbyte32 = oroch::svbyte_codec<uint32_t>;
+using svbyte64 = oroch::svbyte_codec<uint64_t>;
+
+TEST_CASE("svbyte codec space calculation", "[svbyte]")
+{
+	REQUIRE(svbyte32::value_space(0) == 1);
+	REQUIRE(svbyte32::value_space(255) == 1);
+	REQUIRE(svbyte32::value_space(256) == 2);
+	REQUIRE(svbyte32::value_space(0x10000) == 3);
+	REQUIRE(svbyte32::value_space(UINT32_MAX) == 4);
+
+	REQUIRE(svbyte64::value_space(0) == 1);
+	REQUIRE(svbyte64::value_space(256) == 2);
+	REQUIRE(svbyte64::value_space(0x10000) == 4);
+	REQUIRE(svbyte64::value_space(0x100000000) == 8);
+	REQUIRE(svbyte64::value_space(UINT64_MAX) == 8);
+
+	std::array<uint32_t, 5> integers{{0, 0x100, 0x10000, 0x1000000, 1}};
+	REQUIRE(svbyte32::space(integers.begin(), integers.end()) == 2 + 11);
+}
+
+TEST_CASE("svbyte codec for array", "[svbyte]")
+{
+	std::array<uint8_t, 2 + 11> bytes;
+	std::array<uint32_t, 5> integers{{0, 0x100, 0x10000, 0x1000000, 1}};
+
+	oroch::dst_bytes_t d_it = bytes.begin();
+	svbyte32::encode(d_it, integers.begin(), integers.end());
+	REQUIRE(d_it == bytes.end());
+	REQUIRE(bytes[0] == 0xe4);
+	REQUIRE(bytes[1] == 0x00);
+
+	std::array<uint32_t, 5> integers2;
+	oroch::src_bytes_t b_it = bytes.begin();
+	svbyte32::decode(integers2.begin(), integers2.end(), b_it);
+	REQUIRE(b_it == bytes.end());
+
+	for (size_t i = 0; i < integers.size(); i++) {
+		REQUIRE(integers[i] == integers2[i]);
+	}
+}
+
+TEST_CASE("svbyte codec for different types", "[svbyte]")
+{
+	for (size_t n : {0, 1, 3, 4, 5, 16, 17, 100, 1000}) {
+		const auto u8 = random_integers<uint8_t>(n);
+		const auto u16 = random_integers<uint16_t>(n);
+		const auto u32 = random_integers<uint32_t>(n);
+		const auto u64 = random_integers<uint64_t>(n);
+		const auto s16 = random_integers<int16_t>(n);
+		const auto s32 = random_integers<int32_t>(n);
+		const auto s64 = random_integers<int64_t>(n);
+
+		using codec_u8 = oroch::svbyte_codec<uint8_t>;
+		using codec_u16 = oroch::svbyte_codec<uint16_t>;
+		using codec_s16 = oroch::svbyte_codec<int16_t>;
+		using codec_s32 = oroch::svbyte_codec<int32_t>;
+		using codec_s64 = oroch::svbyte_codec<int64_t>;
+		check_codec<codec_u8>(u8, codec_u8::space(u8.begin(), u8.end()));
+		check_codec<codec_u16>(u16, codec_u16::space(u16.begin(), u16.end()));
+		check_codec<svbyte32>(u32, svbyte32::space(u32.begin(), u32.end()));
+		check_codec<svbyte64>(u64, svbyte64::space(u64.begin(), u64.end()));
+		check_codec<codec_s16>(s16, codec_s16::space(s16.begin(), s16.end()));
+		check_codec<codec_s32>(s32, codec_s32::space(s32.begin(), s32.end()));
+		check_codec<codec_s64>(s64, codec_s64::space(s64.begin(), s64.end()));
+	}
+
+	using codec = oroch::svbyte_codec<int64_t, oroch::origin_codec<int64_t>>;
+	const oroch::origin_codec<int64_t> vcodec(1000);
+	std::vector<int64_t> integers(100);
+	for (size_t i = 0; i < integers.size(); i++)
+		integers[i] = 1000 + i * i;
+	const size_t space = codec::space(integers.begin(), integers.end(), vcodec);
+	check_codec<codec>(integers, space, vcodec);
+}
@@ -1,6 +1,10 @@
 #include "catch.hpp"
+#include "codec_check.h"
 
 #include <array>
+#include <vector>
+
+#include <oroch/origin.h>
 #include <oroch/varint.h>
 
 using varint32 = oroch::varint_codec<uint32_t>;
@@ -82,3 +86,44 @@ TEST_CASE("varint codec for array", "[varint]")
 		REQUIRE(integers[i] == integers2[i]);
 	}
 }
+
+template <typename T, typename V = oroch::zigzag_codec<T>>
+static void
+check_bulk_decode(const std::vector<T> &integers, V vcodec = V())
+{
+	using codec = oroch::varint_codec<T, V>;
+
+	std::vector<uint8_t> bytes(codec::space(integers.begin(), integers.end(), vcodec));
+	oroch::dst_bytes_t d_it = bytes.data();
+	codec::encode(d_it, integers.begin(), integers.end(), vcodec);
+	REQUIRE(d_it == bytes.data() + bytes.size());
+
+	std::vector<T> integers2(integers.size());
+	oroch::src_bytes_t b_it = bytes.data();
+	codec::decode(integers2.begin(), integers2.end(), b_it, vcodec);
+	REQUIRE(b_it == bytes.data() + bytes.size());
+
+	b_it = bytes.data();
+	for (size_t i = 0; i < integers.size(); i++) {
+		REQUIRE(integers2[i] == integers[i]);
+		REQUIRE(codec::value_decode(b_it, vcodec) == integers[i]);
+	}
+}
+
+TEST_CASE("varint codec bulk decode", "[varint]")
+{
+	for (size_t n : {0, 1, 15, 16, 17, 100, 1000}) {
+		check_bulk_decode(random_integers<uint8_t>(n));
+		check_bulk_decode(random_integers<uint16_t>(n));
+		check_bulk_decode(random_integers<uint32_t>(n));
+		check_bulk_decode(random_integers<uint64_t>(n));
+		check_bulk_decode(random_integers<int16_t>(n));
+		check_bulk_decode(random_integers<int32_t>(n));
+		check_bulk_decode(random_integers<int64_t>(n));
+	}
+
+	std::vector<int32_t> integers(1000);
+	for (size_t i = 0; i < integers.size(); i++)
+		integers[i] = -1000 + (i % 3 ? int32_t(i) : int32_t(i * i * 100));
+	check_bulk_decode(integers, oroch::origin_codec<int32_t>(-1000));
+}